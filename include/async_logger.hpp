@@ -0,0 +1,521 @@
+#pragma once
+// Low-latency asynchronous logger
+// Producers copy the format pointer and raw arguments into their own byte ring, a background thread formats and writev()s
+
+#include "atomic_queue.hpp"
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace sl{
+    // Tags for what a producer does when its ring is full
+    struct DropWhenFull{};  // discard, counted in dropped() but not reported in the log
+    struct BlockWhenFull{}; // spin until the background thread frees space
+    struct CountWhenFull{}; // discard and report the count in the log
+    template<typename T>
+    concept IsFullPolicy = std::is_same_v<T, DropWhenFull> || std::is_same_v<T, BlockWhenFull> || std::is_same_v<T, CountWhenFull>;
+    enum class LogLevel : uint32_t{ Debug, Info, Warn, Error };
+    static constexpr const char* to_string(LogLevel level) noexcept{
+        switch(level){
+            case LogLevel::Debug: return "DEBUG";
+            case LogLevel::Info: return "INFO";
+            case LogLevel::Warn: return "WARN";
+            default: return "ERROR";
+        }
+    }
+    static constexpr size_t max_log_threads = 64;
+    static constexpr size_t log_record_align = 8;
+
+    // Encoding of one argument inside a record, strings are copied so the caller's buffer may die right away
+    template<typename T>
+    struct LogArg;
+    template<typename T>
+    requires std::is_arithmetic_v<T> || std::is_enum_v<T> || (std::is_pointer_v<T> && !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char>)
+    struct LogArg<T>{
+        static size_t size(const T&) noexcept{ return sizeof(T); }
+        static std::byte *encode(std::byte *out, const T &value) noexcept{
+            std::memcpy(out, &value, sizeof(T));
+            return out + sizeof(T);
+        }
+        static auto decode(const std::byte *&in) noexcept{
+            T value;
+            std::memcpy(&value, in, sizeof(T));
+            in += sizeof(T);
+            // printf needs the promoted type for enums
+            if constexpr(std::is_enum_v<T>){
+                return static_cast<std::underlying_type_t<T>>(value);
+            }else{
+                return value;
+            }
+        }
+    };
+    struct LogStringArg{
+        static size_t size(std::string_view text) noexcept{ return sizeof(uint32_t) + text.size() + 1; }
+        static std::byte *encode(std::byte *out, std::string_view text) noexcept{
+            const uint32_t length = static_cast<uint32_t>(text.size());
+            std::memcpy(out, &length, sizeof(length));
+            std::memcpy(out + sizeof(length), text.data(), length);
+            out[sizeof(length) + length] = std::byte{0};
+            return out + sizeof(length) + length + 1;
+        }
+        static const char *decode(const std::byte *&in) noexcept{
+            uint32_t length;
+            std::memcpy(&length, in, sizeof(length));
+            const char *text = reinterpret_cast<const char*>(in + sizeof(length));
+            in += sizeof(length) + length + 1;
+            return text;
+        }
+    };
+    template<> struct LogArg<const char*> : LogStringArg{
+        static size_t size(const char *text) noexcept{ return LogStringArg::size(text ? text : "(null)"); }
+        static std::byte *encode(std::byte *out, const char *text) noexcept{ return LogStringArg::encode(out, text ? text : "(null)"); }
+    };
+    template<> struct LogArg<char*> : LogArg<const char*>{};
+    template<> struct LogArg<std::string_view> : LogStringArg{};
+    template<> struct LogArg<std::string> : LogStringArg{};
+    template<typename T>
+    concept IsLoggable = requires(const std::decay_t<T> &value, std::byte *out, const std::byte *in){
+        { LogArg<std::decay_t<T>>::size(value) } -> std::convertible_to<size_t>;
+        LogArg<std::decay_t<T>>::encode(out, value);
+        LogArg<std::decay_t<T>>::decode(in);
+    };
+    using LogFormatFn = int (*)(char *out, size_t capacity, const char *format, const std::byte *args);
+    // Fixed part of every record, the arguments follow it
+    struct LogRecordHeader{
+        uint32_t size_;       // whole record including padding, 0 marks a wrap to the ring start
+        uint32_t level_;
+        uint64_t tsc_;
+        const char *format_;  // must outlive the logger, in practice a string literal
+        LogFormatFn format_fn_;
+    };
+    static_assert(sizeof(LogRecordHeader) % log_record_align == 0);
+    template<typename ...Args>
+    static int format_log_record(char *out, size_t capacity, const char *format, const std::byte *args) noexcept{
+        const std::byte *cursor = args;
+        // Braced initialisation decodes the arguments left to right
+        std::tuple<decltype(LogArg<Args>::decode(cursor))...> values{LogArg<Args>::decode(cursor)...};
+        #pragma GCC diagnostic push
+        #pragma GCC diagnostic ignored "-Wformat-nonliteral"
+        #pragma GCC diagnostic ignored "-Wformat-security"
+        return std::apply([&](auto... value){ return std::snprintf(out, capacity, format, value...); }, values);
+        #pragma GCC diagnostic pop
+    }
+    // SPSC ring of variable sized records, the owning thread writes and the background thread reads
+    class LogRing{
+        private:
+            alignas(cache_line) std::atomic<size_t> head_{0}; // Consumer index in bytes
+            size_t cached_tail_ = 0;
+            alignas(cache_line) std::atomic<size_t> tail_{0}; // Producer index in bytes
+            size_t cached_head_ = 0;
+            size_t pending_ = 0;
+            std::atomic<uint64_t> dropped_{0};
+            alignas(cache_line) std::atomic<uintptr_t> owner_{0};
+            uint64_t reported_dropped_ = 0; // background thread only
+            const size_t capacity_;
+            std::unique_ptr<std::byte[]> data_;
+        public:
+            explicit LogRing(size_t capacity):
+            capacity_(capacity),
+            data_(new std::byte[capacity]){
+                // Fault the ring in now instead of on the first log calls
+                std::memset(data_.get(), 0, capacity_);
+            }
+            std::atomic<uintptr_t> &owner() noexcept{ return owner_; }
+            // Contiguous space for `bytes`, nullptr when full, commit() publishes it
+            std::byte *reserve(size_t bytes) noexcept{
+                const size_t pos = tail_.load(std::memory_order_relaxed);
+                const size_t offset = pos & (capacity_ - 1);
+                const size_t wrap = offset + bytes > capacity_ ? capacity_ - offset : 0;
+                const size_t needed = wrap + bytes;
+                if(pos + needed - cached_head_ > capacity_){
+                    cached_head_ = head_.load(std::memory_order_acquire);
+                    if(pos + needed - cached_head_ > capacity_){
+                        return nullptr;
+                    }
+                }
+                if(wrap){
+                    // Records never straddle the end, a zero size header sends the reader back to the start
+                    const uint32_t marker = 0;
+                    std::memcpy(data_.get() + offset, &marker, sizeof(marker));
+                }
+                pending_ = pos + needed;
+                return data_.get() + (wrap ? 0 : offset);
+            }
+            void commit() noexcept{
+                tail_.store(pending_, std::memory_order_release);
+            }
+            void count_drop() noexcept{
+                dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+            // Next record for the background thread, nullptr when empty
+            const LogRecordHeader *peek() noexcept{
+                while(true){
+                    const size_t pos = head_.load(std::memory_order_relaxed);
+                    if(pos == cached_tail_){
+                        cached_tail_ = tail_.load(std::memory_order_acquire);
+                        if(pos == cached_tail_){
+                            return nullptr;
+                        }
+                    }
+                    const size_t offset = pos & (capacity_ - 1);
+                    uint32_t size;
+                    std::memcpy(&size, data_.get() + offset, sizeof(size));
+                    if(size == 0){
+                        head_.store(pos + capacity_ - offset, std::memory_order_release);
+                        continue;
+                    }
+                    return reinterpret_cast<const LogRecordHeader*>(data_.get() + offset);
+                }
+            }
+            void pop(const LogRecordHeader *record) noexcept{
+                head_.store(head_.load(std::memory_order_relaxed) + record->size_, std::memory_order_release);
+            }
+            size_t head() const noexcept{ return head_.load(std::memory_order_acquire); }
+            size_t tail() const noexcept{ return tail_.load(std::memory_order_acquire); }
+            uint64_t dropped() const noexcept{ return dropped_.load(std::memory_order_relaxed); }
+            uint64_t take_new_drops() noexcept{
+                const uint64_t total = dropped();
+                const uint64_t fresh = total - reported_dropped_;
+                reported_dropped_ = total;
+                return fresh;
+            }
+    };
+    template<typename FullPolicy = CountWhenFull, size_t RingBytes = (size_t(1) << 20)>
+    requires IsFullPolicy<FullPolicy> && ValidSizeParameter<RingBytes,EnablePowerOfTwo> && (RingBytes >= 4096)
+    class AsyncLogger{
+        private:
+            static constexpr size_t chunk_bytes = 16 * 1024;
+            static constexpr size_t chunk_count = 16; // iovecs per writev
+            // Keyed by instance id, a new logger may reuse a destroyed one's address
+            struct RingCache{
+                uint64_t logger_ = 0;
+                LogRing *ring_ = nullptr;
+            };
+            std::array<std::atomic<LogRing*>, max_log_threads> rings_{};
+            std::array<std::shared_ptr<LogRing>, max_log_threads> owned_;
+            std::atomic<uint64_t> unregistered_drops_{0};
+            std::atomic<LogLevel> min_level_{LogLevel::Debug};
+            std::atomic<bool> stop_{false};
+            alignas(cache_line) std::atomic<uint64_t> passes_{0};
+            std::atomic<uint64_t> written_bytes_{0};
+            const uint64_t id_;
+            const int fd_;
+            const bool owns_fd_;
+            // rdtsc to wall clock conversion, fixed at construction
+            const uint64_t base_tsc_;
+            const int64_t base_ns_;
+            const double ticks_per_ns_;
+            std::thread writer_;
+
+            // Gives the exiting thread's rings back so later threads can claim them
+            // The release store pairs with the claiming CAS, so the next owner sees the ring's producer state
+            // Weak references, a logger destroyed before the thread exits has already freed its rings
+            struct RingRelease{
+                std::vector<std::weak_ptr<LogRing>> rings_;
+                void add(const std::shared_ptr<LogRing> &ring){
+                    std::erase_if(rings_, [](const std::weak_ptr<LogRing> &weak){ return weak.expired(); });
+                    rings_.push_back(ring);
+                }
+                ~RingRelease(){
+                    for(auto &weak : rings_){
+                        if(std::shared_ptr<LogRing> ring = weak.lock()){
+                            ring->owner().store(0, std::memory_order_release);
+                        }
+                    }
+                }
+            };
+            // Ring of the calling thread, allocated on its first log call
+            LogRing *local_ring() noexcept{
+                static thread_local RingCache cache;
+                static thread_local RingRelease release;
+                const uintptr_t token = trace_thread_token();
+                if(cache.logger_ == id_ && cache.ring_->owner().load(std::memory_order_relaxed) == token){
+                    return cache.ring_;
+                }
+                for(size_t i = 0; i < max_log_threads; ++i){
+                    LogRing *ring = rings_[i].load(std::memory_order_acquire);
+                    if(ring && ring->owner().load(std::memory_order_relaxed) == token){
+                        cache = RingCache{id_, ring};
+                        return ring;
+                    }
+                }
+                for(size_t i = 0; i < max_log_threads; ++i){
+                    uintptr_t owner = 0;
+                    LogRing *ring = rings_[i].load(std::memory_order_acquire);
+                    if(ring && ring->owner().compare_exchange_strong(owner, token, std::memory_order_acq_rel)){
+                        // The previous owner stored owned_[i] before releasing the ring
+                        release.add(owned_[i]);
+                        cache = RingCache{id_, ring};
+                        return ring;
+                    }
+                    if(!ring){
+                        auto fresh = std::shared_ptr<LogRing>(new(std::nothrow) LogRing(RingBytes));
+                        if(!fresh){
+                            return nullptr;
+                        }
+                        fresh->owner().store(token, std::memory_order_relaxed);
+                        LogRing *expected = nullptr;
+                        if(rings_[i].compare_exchange_strong(expected, fresh.get(), std::memory_order_acq_rel)){
+                            cache = RingCache{id_, fresh.get()};
+                            release.add(fresh);
+                            owned_[i] = std::move(fresh);
+                            return cache.ring_;
+                        }
+                    }
+                }
+                return nullptr;
+            }
+            size_t format_line(char *out, size_t capacity, const LogRecordHeader &record) const noexcept{
+                const int64_t ns = base_ns_ + int64_t(double(int64_t(record.tsc_ - base_tsc_)) / ticks_per_ns_);
+                const int prefix = std::snprintf(out, capacity, "%lld.%09lld %-5s ",
+                    static_cast<long long>(ns / 1000000000), static_cast<long long>(ns % 1000000000),
+                    to_string(static_cast<LogLevel>(record.level_)));
+                if(prefix < 0 || size_t(prefix) >= capacity){
+                    return 0;
+                }
+                const int body = record.format_fn_(out + prefix, capacity - prefix, record.format_,
+                                                   reinterpret_cast<const std::byte*>(&record + 1));
+                size_t length = size_t(prefix) + (body < 0 ? 0 : size_t(body));
+                // Long lines are truncated to the chunk size, they still end with a newline
+                length = length >= capacity ? capacity - 1 : length;
+                out[length] = '\n';
+                return length + 1;
+            }
+            void write_all(struct iovec *iov, int count) noexcept{
+                while(count > 0){
+                    const ssize_t written = ::writev(fd_, iov, count);
+                    if(written < 0){
+                        if(errno == EINTR){
+                            continue;
+                        }
+                        return;
+                    }
+                    written_bytes_.fetch_add(size_t(written), std::memory_order_relaxed);
+                    size_t left = size_t(written);
+                    while(count > 0 && left >= iov->iov_len){
+                        left -= iov->iov_len;
+                        ++iov;
+                        --count;
+                    }
+                    if(count > 0){
+                        iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+                        iov->iov_len -= left;
+                    }
+                }
+            }
+            void run() noexcept{
+                std::unique_ptr<char[]> chunks(new char[chunk_bytes * chunk_count]);
+                struct iovec iov[chunk_count];
+                size_t idle = 0;
+                while(true){
+                    const bool stopping = stop_.load(std::memory_order_acquire);
+                    size_t chunk = 0, used = 0;
+                    bool found = false;
+                    auto flush_chunks = [&]{
+                        int count = 0;
+                        for(size_t c = 0; c <= chunk && c < chunk_count; ++c){
+                            const size_t length = c == chunk ? used : iov[c].iov_len;
+                            if(length){
+                                iov[count].iov_base = chunks.get() + c * chunk_bytes;
+                                iov[count].iov_len = length;
+                                ++count;
+                            }
+                        }
+                        write_all(iov, count);
+                        chunk = 0;
+                        used = 0;
+                    };
+                    auto emit = [&](auto &&format){
+                        size_t length = format(chunks.get() + chunk * chunk_bytes + used, chunk_bytes - used);
+                        if(length == 0 || used + length >= chunk_bytes){
+                            // Close this chunk and retry in a fresh one
+                            iov[chunk].iov_len = used;
+                            if(++chunk == chunk_count){
+                                chunk = chunk_count - 1;
+                                flush_chunks();
+                            }
+                            used = 0;
+                            length = format(chunks.get() + chunk * chunk_bytes, chunk_bytes);
+                        }
+                        used += length;
+                    };
+                    for(size_t i = 0; i < max_log_threads; ++i){
+                        LogRing *ring = rings_[i].load(std::memory_order_acquire);
+                        if(!ring){
+                            break;
+                        }
+                        // Bounded drain so one chatty thread cannot starve the others
+                        for(size_t n = 0; n < 1024; ++n){
+                            const LogRecordHeader *record = ring->peek();
+                            if(!record){
+                                break;
+                            }
+                            found = true;
+                            emit([&](char *out, size_t capacity){ return format_line(out, capacity, *record); });
+                            ring->pop(record);
+                        }
+                        if constexpr(std::is_same_v<FullPolicy, CountWhenFull>){
+                            if(const uint64_t drops = ring->take_new_drops()){
+                                // Synthetic record so the report carries the usual timestamp and level
+                                struct{
+                                    LogRecordHeader header_;
+                                    std::byte args_[sizeof(unsigned long long) + sizeof(size_t)];
+                                } report{{sizeof(report), static_cast<uint32_t>(LogLevel::Warn), rdtsc(),
+                                          "logger: dropped %llu messages from thread slot %zu",
+                                          &format_log_record<unsigned long long, size_t>}, {}};
+                                LogArg<size_t>::encode(LogArg<unsigned long long>::encode(report.args_, drops), i);
+                                emit([&](char *out, size_t capacity){ return format_line(out, capacity, report.header_); });
+                            }
+                        }
+                    }
+                    if(chunk != 0 || used != 0){
+                        flush_chunks();
+                    }
+                    passes_.fetch_add(1, std::memory_order_release);
+                    if(found){
+                        idle = 0;
+                        continue;
+                    }
+                    if(stopping){
+                        return;
+                    }
+                    if(++idle < 64){
+                        std::this_thread::yield();
+                    }else{
+                        std::this_thread::sleep_for(std::chrono::microseconds(50));
+                    }
+                }
+            }
+            static uint64_t next_id() noexcept{
+                static std::atomic<uint64_t> ids{0};
+                return ids.fetch_add(1, std::memory_order_relaxed) + 1;
+            }
+            AsyncLogger(int fd, bool owns_fd):
+            id_(next_id()),
+            fd_(fd),
+            owns_fd_(owns_fd),
+            base_tsc_(rdtsc()),
+            base_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count()),
+            ticks_per_ns_(calibrate_tsc(std::chrono::milliseconds(5))),
+            writer_([this]{ run(); }){}
+        public:
+            // Appends to `path`, check good() for a failed open
+            explicit AsyncLogger(const char *path):
+            AsyncLogger(::open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644), true){}
+            // Writes to an fd the caller keeps ownership of, such as STDOUT_FILENO
+            explicit AsyncLogger(int fd):
+            AsyncLogger(fd, false){}
+            // Everything logged before destruction is written
+            ~AsyncLogger(){
+                stop_.store(true, std::memory_order_release);
+                writer_.join();
+                if(owns_fd_ && fd_ >= 0){
+                    ::close(fd_);
+                }
+            }
+            AsyncLogger(const AsyncLogger&) = delete;
+            AsyncLogger& operator=(const AsyncLogger&) = delete;
+            AsyncLogger(AsyncLogger&&) = delete;
+            AsyncLogger& operator=(AsyncLogger&&) = delete;
+
+            bool good() const noexcept{
+                return fd_ >= 0;
+            }
+            void set_level(LogLevel level) noexcept{
+                min_level_.store(level, std::memory_order_relaxed);
+            }
+            // Allocate the calling thread's ring ahead of its first log call
+            bool attach_thread() noexcept{
+                return local_ring() != nullptr;
+            }
+            // Hot path: one ring reservation and a memcpy per argument, no formatting and no allocation
+            // format is printf syntax and must outlive the logger, strings arguments are copied
+            template<typename ...Args>
+            requires (IsLoggable<Args> && ...)
+            bool log(LogLevel level, const char *format, const Args &... args) noexcept{
+                if(level < min_level_.load(std::memory_order_relaxed)){
+                    return true;
+                }
+                LogRing *ring = local_ring();
+                if(!ring){
+                    unregistered_drops_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                size_t bytes = sizeof(LogRecordHeader);
+                ((bytes += LogArg<std::decay_t<Args>>::size(args)), ...);
+                bytes = (bytes + log_record_align - 1) & ~(log_record_align - 1);
+                if(bytes > RingBytes / 2){
+                    ring->count_drop();
+                    return false;
+                }
+                std::byte *out = ring->reserve(bytes);
+                if(!out){
+                    if constexpr(std::is_same_v<FullPolicy, BlockWhenFull>){
+                        while(!(out = ring->reserve(bytes))){
+                            cpu_relax();
+                        }
+                    }else{
+                        ring->count_drop();
+                        return false;
+                    }
+                }
+                const LogRecordHeader header{static_cast<uint32_t>(bytes), static_cast<uint32_t>(level), rdtsc(),
+                                             format, &format_log_record<std::decay_t<Args>...>};
+                std::memcpy(out, &header, sizeof(header));
+                std::byte *cursor = out + sizeof(header);
+                ((cursor = LogArg<std::decay_t<Args>>::encode(cursor, args)), ...);
+                ring->commit();
+                return true;
+            }
+            template<typename ...Args>
+            bool debug(const char *format, const Args &... args) noexcept{ return log(LogLevel::Debug, format, args...); }
+            template<typename ...Args>
+            bool info(const char *format, const Args &... args) noexcept{ return log(LogLevel::Info, format, args...); }
+            template<typename ...Args>
+            bool warn(const char *format, const Args &... args) noexcept{ return log(LogLevel::Warn, format, args...); }
+            template<typename ...Args>
+            bool error(const char *format, const Args &... args) noexcept{ return log(LogLevel::Error, format, args...); }
+            // Waits until everything logged before the call has been handed to the kernel
+            void flush() noexcept{
+                std::array<size_t, max_log_threads> tails{};
+                for(size_t i = 0; i < max_log_threads; ++i){
+                    LogRing *ring = rings_[i].load(std::memory_order_acquire);
+                    tails[i] = ring ? ring->tail() : 0;
+                }
+                for(size_t i = 0; i < max_log_threads; ++i){
+                    LogRing *ring = rings_[i].load(std::memory_order_acquire);
+                    while(ring && int64_t(ring->head() - tails[i]) < 0){
+                        std::this_thread::yield();
+                    }
+                }
+                // The pass that consumed the last record writes it before it completes
+                const uint64_t pass = passes_.load(std::memory_order_acquire);
+                while(passes_.load(std::memory_order_acquire) <= pass + 1){
+                    std::this_thread::yield();
+                }
+            }
+            // Messages lost to full rings or to running out of thread slots
+            uint64_t dropped() const noexcept{
+                uint64_t total = unregistered_drops_.load(std::memory_order_relaxed);
+                for(size_t i = 0; i < max_log_threads; ++i){
+                    if(LogRing *ring = rings_[i].load(std::memory_order_acquire)){
+                        total += ring->dropped();
+                    }
+                }
+                return total;
+            }
+            uint64_t written_bytes() const noexcept{
+                return written_bytes_.load(std::memory_order_relaxed);
+            }
+    };
+}
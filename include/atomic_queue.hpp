@@ -3,15 +3,31 @@
 // Will use concepts of C++20   
 
 
+#include <algorithm>
 #include <atomic>
 #include <concepts>
 #include <new>
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <array>
 #include <memory>
 #include <type_traits>
 #include <iostream>
+#include <cstdint>
+#include <bit>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+#if defined(__unix__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 
 
@@ -21,6 +37,14 @@ namespace sl{
     // Two struct tags for buffer types
     struct UseHeapBuffer{};
     struct UseStackBuffer{};
+    // Freshly mapped zero pages, the queue skips its construction pass
+    struct UseZeroPageBuffer{};
+    // Tags for optional latency tracing, sample one message out of every SampleEvery
+    struct DisableTracing{};
+    template<size_t SampleEvery = 1024>
+    struct EnableTracing{
+        static constexpr size_t sample_every = SampleEvery;
+    };
     #if defined(__cpp_lib_hardware_interference_size)
     static constexpr size_t cache_line = std::hardware_destructive_interference_size;
     #else
@@ -40,6 +64,8 @@ namespace sl{
     template<typename T>
     concept IsStackBuffer = std::is_same_v<T, UseStackBuffer>;
     template<typename T>
+    concept IsZeroPageBuffer = std::is_same_v<T, UseZeroPageBuffer>;
+    template<typename T>
     concept IsValidConstraint = IsEnablePowerOfTwo<T> || IsDisablePowerOfTwo<T>;
     template<typename T>
     concept IsAligned = alignof(T) % cache_line == 0;
@@ -55,7 +81,15 @@ namespace sl{
                         &&std::is_trivially_copyable_v<T>
                         &&std::is_trivially_destructible_v<T>;
     template<typename T>
-    concept IsValidBufferType = IsHeapBuffer<T> || IsStackBuffer<T>;
+    concept IsValidBufferType = IsHeapBuffer<T> || IsStackBuffer<T> || IsZeroPageBuffer<T>;
+    template<typename T>
+    concept IsTracingDisabled = std::is_same_v<T, DisableTracing>;
+    template<typename T>
+    concept IsTracingEnabled = requires { T::sample_every; }
+                               && std::is_same_v<T, EnableTracing<T::sample_every>>
+                               && (T::sample_every > 0);
+    template<typename T>
+    concept IsValidTracePolicy = IsTracingDisabled<T> || IsTracingEnabled<T>;
     // to do plus1
     template<typename T,IsValidConstraint SizeConstraint,bool Modulo,size_t N=0>
     // Heap buffer implementation for dynamic size allocation
@@ -125,6 +159,95 @@ namespace sl{
             }
         }
     };
+    template<typename T,IsValidConstraint SizeConstraint,bool Modulo,size_t N=0>
+    // Buffer of anonymous pages that read as zero until written, the kernel supplies each page on first touch
+    // Only valid for cells whose all-zero bytes are a usable initial state
+    class ZeroPageBuffer{
+        private:
+        T *buffer_;
+        const size_t buffer_size_;
+        const size_t buffer_mask_;
+        const size_t bytes_;
+        static size_t page_size() noexcept{
+            #if defined(__unix__)
+            return size_t(sysconf(_SC_PAGESIZE));
+            #else
+            return 4096;
+            #endif
+        }
+        public:
+        explicit ZeroPageBuffer(const size_t size,const std::allocator<T>& = std::allocator<T>()):
+        buffer_size_(size),
+        buffer_mask_(size-1),
+        bytes_(((size+1)*sizeof(T)+page_size()-1)/page_size()*page_size()){
+            #if defined(__unix__)
+            void *memory = mmap(nullptr,bytes_,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+            if(memory == MAP_FAILED){
+                throw std::bad_alloc();
+            }
+            buffer_ = static_cast<T*>(memory);
+            #else
+            buffer_ = static_cast<T*>(::operator new(bytes_,std::align_val_t(alignof(T))));
+            std::memset(static_cast<void*>(buffer_),0,bytes_);
+            #endif
+        }
+        ~ZeroPageBuffer() noexcept{
+            #if defined(__unix__)
+            munmap(buffer_,bytes_);
+            #else
+            ::operator delete(buffer_,std::align_val_t(alignof(T)));
+            #endif
+        }
+        ZeroPageBuffer(const ZeroPageBuffer&) = delete;
+        ZeroPageBuffer& operator=(const ZeroPageBuffer&) = delete;
+        // Slot an index maps to, the same reduction operator[] applies
+        size_t index_of(const size_t index) const noexcept{
+            if constexpr(!Modulo){
+                return index;
+            }else if constexpr(IsEnablePowerOfTwo<SizeConstraint>){
+                return index&buffer_mask_;
+            }else if constexpr(N!=0){
+                return index%N;
+            }else{
+                return index%buffer_size_;
+            }
+        }
+        T& operator[](const size_t index) noexcept{
+            return buffer_[index_of(index)];
+        }
+        const T& operator[](const size_t index) const noexcept{
+            return buffer_[index_of(index)];
+        }
+        // Fault every page in now, split across threads so the kernel zeroes them in parallel
+        // Must run before the buffer is shared, the fallback path rewrites one byte per page
+        void prefault(size_t threads) noexcept{
+            const size_t page = page_size();
+            const size_t pages = bytes_/page;
+            threads = threads ? threads : std::max<size_t>(1,std::thread::hardware_concurrency());
+            threads = std::min(threads,pages);
+            auto touch = [this,page](size_t first,size_t last){
+                std::byte *begin = reinterpret_cast<std::byte*>(buffer_)+first*page;
+                #if defined(MADV_POPULATE_WRITE)
+                if(madvise(begin,(last-first)*page,MADV_POPULATE_WRITE) == 0){
+                    return;
+                }
+                #endif
+                for(size_t p = first; p < last; ++p){
+                    volatile std::byte *byte = begin+(p-first)*page;
+                    *byte = *byte;
+                }
+            };
+            std::vector<std::thread> workers;
+            workers.reserve(threads);
+            for(size_t t = 1; t < threads; ++t){
+                workers.emplace_back(touch,pages*t/threads,pages*(t+1)/threads);
+            }
+            touch(0,pages/threads);
+            for(auto &worker : workers){
+                worker.join();
+            }
+        }
+    };
     template <bool HasSeq>
     struct SeqField;
     
@@ -144,7 +267,7 @@ namespace sl{
     // Specializations for tracking object construction state
     template<bool HasSeq>
     struct IsConstructedField<HasSeq,true>{
-        IsConstructedField(bool isconstructed){}
+        IsConstructedField(bool){}
     };
     template<>
     struct IsConstructedField<true,false>{
@@ -223,10 +346,271 @@ namespace sl{
     template<typename T, size_t N, typename SizeConstraint>
     concept IsValidMPMCQueue = ValidSizeParameter<N,SizeConstraint> && FalseSharingSafe<Cell<T,true>>;
     
+    // Read the time stamp counter, falls back to steady_clock ticks on other architectures
+    static inline uint64_t rdtsc() noexcept{
+        #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+        #else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        #endif
+    }
+    // Measure how many rdtsc ticks elapse per nanosecond, used to convert exported histograms
+    static inline double calibrate_tsc(std::chrono::milliseconds duration = std::chrono::milliseconds(10)) noexcept{
+        const auto start_time = std::chrono::steady_clock::now();
+        const uint64_t start_tsc = rdtsc();
+        auto end_time = start_time;
+        while(end_time - start_time < duration){
+            end_time = std::chrono::steady_clock::now();
+        }
+        const uint64_t end_tsc = rdtsc();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+        return elapsed.count() > 0 ? double(end_tsc - start_tsc) / double(elapsed.count()) : 1.0;
+    }
+    // Plain copy of a LatencyHistogram, safe to inspect and merge off the hot path
+    class HistogramSnapshot{
+        public:
+            // HDR-style log-linear layout: 2^SubBucketBits linear buckets per power of two
+            static constexpr size_t sub_bucket_bits = 4;
+            static constexpr size_t sub_buckets = size_t(1) << sub_bucket_bits;
+            static constexpr size_t bucket_count = (65 - sub_bucket_bits) * sub_buckets;
+
+            static constexpr size_t bucket_index(uint64_t value) noexcept{
+                if(value < 2 * sub_buckets){
+                    return static_cast<size_t>(value);
+                }
+                const size_t shift = std::bit_width(value) - (sub_bucket_bits + 1);
+                return (shift + 1) * sub_buckets + static_cast<size_t>((value >> shift) - sub_buckets);
+            }
+            // Smallest value that lands in the bucket
+            static constexpr uint64_t bucket_lower_bound(size_t index) noexcept{
+                if(index < 2 * sub_buckets){
+                    return index;
+                }
+                const size_t shift = index / sub_buckets - 1;
+                return (uint64_t(sub_buckets) + index % sub_buckets) << shift;
+            }
+
+            uint64_t count() const noexcept{ return count_; }
+            uint64_t min() const noexcept{ return count_ ? min_ : 0; }
+            uint64_t max() const noexcept{ return max_; }
+            double mean() const noexcept{ return count_ ? double(sum_) / double(count_) : 0.0; }
+            uint64_t bucket(size_t index) const noexcept{ return counts_[index]; }
+            // Lower bound of the bucket holding the requested percentile in [0,100]
+            uint64_t value_at_percentile(double percentile) const noexcept{
+                if(count_ == 0){
+                    return 0;
+                }
+                const double clamped = percentile < 0.0 ? 0.0 : (percentile > 100.0 ? 100.0 : percentile);
+                uint64_t target = static_cast<uint64_t>(clamped / 100.0 * double(count_) + 0.5);
+                target = target == 0 ? 1 : target;
+                uint64_t seen = 0;
+                for(size_t i = 0; i < bucket_count; ++i){
+                    seen += counts_[i];
+                    if(seen >= target){
+                        const uint64_t lower = bucket_lower_bound(i);
+                        return lower < min_ ? min_ : (lower > max_ ? max_ : lower);
+                    }
+                }
+                return max_;
+            }
+            void merge(const HistogramSnapshot &other) noexcept{
+                for(size_t i = 0; i < bucket_count; ++i){
+                    counts_[i] += other.counts_[i];
+                }
+                if(other.count_ != 0){
+                    min_ = count_ == 0 || other.min_ < min_ ? other.min_ : min_;
+                    max_ = other.max_ > max_ ? other.max_ : max_;
+                }
+                count_ += other.count_;
+                sum_ += other.sum_;
+            }
+            void print(std::ostream &os, double ticks_per_ns = 1.0) const{
+                os << "count=" << count_
+                   << " min=" << double(min()) / ticks_per_ns
+                   << " mean=" << mean() / ticks_per_ns
+                   << " p50=" << double(value_at_percentile(50.0)) / ticks_per_ns
+                   << " p99=" << double(value_at_percentile(99.0)) / ticks_per_ns
+                   << " p99.9=" << double(value_at_percentile(99.9)) / ticks_per_ns
+                   << " max=" << double(max_) / ticks_per_ns;
+            }
+        private:
+            friend class LatencyHistogram;
+            std::array<uint64_t, bucket_count> counts_{};
+            uint64_t count_ = 0;
+            uint64_t sum_ = 0;
+            uint64_t min_ = 0;
+            uint64_t max_ = 0;
+    };
+    // Histogram written by one thread and read by the exporter, relaxed atomics avoid torn reads
+    class LatencyHistogram{
+        private:
+            std::array<std::atomic<uint64_t>, HistogramSnapshot::bucket_count> counts_{};
+            std::atomic<uint64_t> count_{0};
+            std::atomic<uint64_t> sum_{0};
+            std::atomic<uint64_t> min_{UINT64_MAX};
+            std::atomic<uint64_t> max_{0};
+        public:
+            void record(uint64_t value) noexcept{
+                counts_[HistogramSnapshot::bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+                count_.fetch_add(1, std::memory_order_relaxed);
+                sum_.fetch_add(value, std::memory_order_relaxed);
+                uint64_t current = min_.load(std::memory_order_relaxed);
+                while(value < current && !min_.compare_exchange_weak(current, value, std::memory_order_relaxed));
+                current = max_.load(std::memory_order_relaxed);
+                while(value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed));
+            }
+            HistogramSnapshot snapshot() const noexcept{
+                HistogramSnapshot result;
+                for(size_t i = 0; i < HistogramSnapshot::bucket_count; ++i){
+                    result.counts_[i] = counts_[i].load(std::memory_order_relaxed);
+                }
+                result.count_ = count_.load(std::memory_order_relaxed);
+                result.sum_ = sum_.load(std::memory_order_relaxed);
+                result.min_ = min_.load(std::memory_order_relaxed);
+                result.max_ = max_.load(std::memory_order_relaxed);
+                return result;
+            }
+    };
+    // Exported histograms of one traced thread, times are in rdtsc ticks
+    struct ThreadLatency{
+        size_t slot_;
+        HistogramSnapshot residency_; // publish to consume
+        HistogramSnapshot seq_wait_;  // spinning on a cell's seq_
+    };
+    static constexpr size_t max_trace_threads = 32;
+    static constexpr size_t max_consumer_groups = 8;
+    static constexpr size_t max_group_members = 16;
+    // Address of a thread_local identifies the calling thread without touching std::thread::id
+    static inline uintptr_t trace_thread_token() noexcept{
+        static thread_local char token;
+        return reinterpret_cast<uintptr_t>(&token);
+    }
+    template<typename TracePolicy, typename SizeConstraint, size_t N>
+    class QueueTracer;
+    // Disabled tracer is empty and every hook is a no-op, the queue keeps its layout
+    template<typename SizeConstraint, size_t N>
+    class QueueTracer<DisableTracing, SizeConstraint, N>{
+        public:
+            explicit QueueTracer(size_t) noexcept {}
+    };
+    // Enabled tracer allocates its stamps and thread slots in the queue's noexcept constructor,
+    // like HeapBuffer an allocation failure there terminates
+    // A thread's slot is released when the thread exits, its histograms stay and the next owner adds to them
+    template<typename TracePolicy, typename SizeConstraint, size_t N>
+    requires IsTracingEnabled<TracePolicy>
+    class QueueTracer<TracePolicy, SizeConstraint, N>{
+        private:
+            struct alignas(cache_line) ThreadTrace{
+                std::atomic<uintptr_t> owner_{0};
+                LatencyHistogram residency_;
+                LatencyHistogram seq_wait_;
+            };
+            // Keyed by instance id, a new tracer may reuse a destroyed one's address
+            struct SlotCache{
+                uint64_t tracer_ = 0;
+                ThreadTrace *slot_ = nullptr;
+            };
+            // Publish stamps live beside the cells so the payload layout is untouched
+            HeapBuffer<uint64_t, SizeConstraint, true, N> stamps_;
+            // Last slot is shared by threads that arrive after the registry is full
+            std::shared_ptr<ThreadTrace[]> threads_;
+            const uint64_t id_;
+
+            // Gives the exiting thread's slots back, weak references skip tracers destroyed first
+            struct SlotRelease{
+                std::vector<std::pair<std::weak_ptr<ThreadTrace[]>, ThreadTrace*>> slots_;
+                void add(const std::shared_ptr<ThreadTrace[]> &threads, ThreadTrace *slot){
+                    std::erase_if(slots_, [](const auto &entry){ return entry.first.expired(); });
+                    slots_.emplace_back(threads, slot);
+                }
+                ~SlotRelease(){
+                    for(auto &[weak, slot] : slots_){
+                        if(std::shared_ptr<ThreadTrace[]> threads = weak.lock()){
+                            slot->owner_.store(0, std::memory_order_release);
+                        }
+                    }
+                }
+            };
+
+            static uint64_t next_id() noexcept{
+                static std::atomic<uint64_t> ids{0};
+                return ids.fetch_add(1, std::memory_order_relaxed) + 1;
+            }
+            ThreadTrace &local() noexcept{
+                static thread_local SlotCache cache;
+                static thread_local SlotRelease release;
+                const uintptr_t token = trace_thread_token();
+                ThreadTrace *overflow = &threads_[max_trace_threads];
+                // A thread on the overflow slot stays there instead of rescanning on every sample
+                if(cache.tracer_ == id_ && (cache.slot_ == overflow || cache.slot_->owner_.load(std::memory_order_relaxed) == token)){
+                    return *cache.slot_;
+                }
+                ThreadTrace *slot = overflow;
+                for(size_t i = 0; i < max_trace_threads; ++i){
+                    uintptr_t owner = threads_[i].owner_.load(std::memory_order_relaxed);
+                    if(owner == token){
+                        slot = &threads_[i];
+                        break;
+                    }
+                    if(owner == 0 && threads_[i].owner_.compare_exchange_strong(owner, token, std::memory_order_acq_rel)){
+                        slot = &threads_[i];
+                        release.add(threads_, slot);
+                        break;
+                    }
+                }
+                cache = SlotCache{id_, slot};
+                return *slot;
+            }
+        public:
+            explicit QueueTracer(size_t buffer_size):
+            stamps_(buffer_size),
+            threads_(new ThreadTrace[max_trace_threads + 1]),
+            id_(next_id()){
+                for(size_t i = 0; i < buffer_size; ++i){
+                    stamps_[i] = 0;
+                }
+            }
+            static constexpr bool sampled(size_t pos) noexcept{
+                return pos % TracePolicy::sample_every == 0;
+            }
+            void record_wait(uint64_t ticks) noexcept{
+                local().seq_wait_.record(ticks);
+            }
+            void stamp(size_t pos, uint64_t now) noexcept{
+                std::atomic_ref<uint64_t>(stamps_[pos]).store(now, std::memory_order_relaxed);
+            }
+            void record_residency(size_t pos, uint64_t now) noexcept{
+                const uint64_t published = std::atomic_ref<uint64_t>(stamps_[pos]).load(std::memory_order_relaxed);
+                local().residency_.record(now > published ? now - published : 0);
+            }
+            std::vector<ThreadLatency> export_trace() const{
+                std::vector<ThreadLatency> result;
+                for(size_t i = 0; i <= max_trace_threads; ++i){
+                    // Released slots keep their histograms, only never used ones are empty
+                    const ThreadTrace &trace = threads_[i];
+                    HistogramSnapshot residency = trace.residency_.snapshot();
+                    HistogramSnapshot seq_wait = trace.seq_wait_.snapshot();
+                    if(residency.count() == 0 && seq_wait.count() == 0){
+                        continue;
+                    }
+                    result.push_back(ThreadLatency{i, std::move(residency), std::move(seq_wait)});
+                }
+                return result;
+            }
+    };
+    
 // Atomic compare-and-swap with increment operation
 static inline bool cas_add(std::atomic<size_t> &seq,size_t val) noexcept{
     return seq.compare_exchange_weak(val,val+1,std::memory_order_relaxed,std::memory_order_relaxed);
 }
+// Spin-wait hint, keeps a polling thread from starving its SMT sibling
+static inline void cpu_relax() noexcept{
+    #if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+    #elif defined(__aarch64__)
+    asm volatile("yield");
+    #endif
+}
 
 // Multiple Producer Multiple Consumer queue implementation
     template<
@@ -234,36 +618,90 @@ static inline bool cas_add(std::atomic<size_t> &seq,size_t val) noexcept{
         size_t N,
         bool Modulo = true,
         IsValidConstraint SizeConstraint = EnablePowerOfTwo,
-        IsValidBufferType BufferType = UseHeapBuffer
+        IsValidBufferType BufferType = UseHeapBuffer,
+        IsValidTracePolicy TracePolicy = DisableTracing
     >
     requires IsValidMPMCQueue<T,N,SizeConstraint>
     class MPMCQueue{
         private:
             static constexpr bool UseStack = std::is_same_v<BufferType,UseStackBuffer>;
+            static constexpr bool ZeroPage = std::is_same_v<BufferType,UseZeroPageBuffer>;
             using value_type = Cell<T,true>;
             using heap_buffer = HeapBuffer<value_type,SizeConstraint,Modulo,N>;
             using stack_buffer = StackBuffer<value_type,N,Modulo>;
+            using zero_page_buffer = ZeroPageBuffer<value_type,SizeConstraint,Modulo,N>;
             using allocator_type = std::allocator<value_type>;
-            using buffer_type = std::conditional_t<UseStack,stack_buffer,heap_buffer>;
+            using buffer_type = std::conditional_t<UseStack,stack_buffer,std::conditional_t<ZeroPage,zero_page_buffer,heap_buffer>>;
             // Cache line aligned buffer to prevent false sharing
             alignas(cache_line) buffer_type buffer_;
             alignas(cache_line) const size_t buffer_size_;
             alignas(cache_line) std::atomic<size_t> head_; // Consumer index
             alignas(cache_line) std::atomic<size_t> tail_; // Producer index
+            static constexpr bool Tracing = IsTracingEnabled<TracePolicy>;
+            using tracer_type = QueueTracer<TracePolicy,SizeConstraint,N>;
+            [[no_unique_address]] tracer_type tracer_;
+            // A zero-page buffer starts with every seq_ at 0, so there seq_ is stored relative to the cell's slot
+            // Slot i then reads back as the usual initial sequence i without a construction pass
+            size_t load_seq(value_type &cell, size_t pos) const noexcept{
+                const size_t seq = cell.seq_.load(std::memory_order_acquire);
+                if constexpr(ZeroPage){
+                    return seq + buffer_.index_of(pos);
+                }
+                return seq;
+            }
+            void store_seq(value_type &cell, size_t pos, size_t seq) noexcept{
+                if constexpr(ZeroPage){
+                    seq -= buffer_.index_of(pos);
+                }
+                cell.seq_.store(seq, std::memory_order_release);
+            }
+            // Tracing hooks, each one compiles to nothing when TracePolicy is DisableTracing
+            uint64_t trace_begin(size_t pos) const noexcept{
+                if constexpr(Tracing){
+                    return tracer_.sampled(pos) ? rdtsc() : 0;
+                }
+                return 0;
+            }
+            void trace_wait(size_t pos, uint64_t start) noexcept{
+                if constexpr(Tracing){
+                    if(tracer_.sampled(pos)){
+                        tracer_.record_wait(rdtsc() - start);
+                    }
+                }
+            }
+            void trace_publish(size_t pos) noexcept{
+                if constexpr(Tracing){
+                    if(tracer_.sampled(pos)){
+                        tracer_.stamp(pos, rdtsc());
+                    }
+                }
+            }
+            void trace_consume(size_t pos) noexcept{
+                if constexpr(Tracing){
+                    if(tracer_.sampled(pos)){
+                        tracer_.record_residency(pos, rdtsc());
+                    }
+                }
+            }
         public:
             explicit MPMCQueue(const size_t buffer_size = N, const allocator_type &allocator = allocator_type()) noexcept:
             buffer_(buffer_size,allocator),
-            buffer_size_(buffer_size){
+            buffer_size_(buffer_size),
+            tracer_(buffer_size){
             // TODO:size validation
-
-            for(size_t i = 0; i < buffer_size_; ++i){
-                new(&buffer_[i]) value_type(i);
+            if constexpr(!ZeroPage){
+                for(size_t i = 0; i < buffer_size_; ++i){
+                    new(&buffer_[i]) value_type(i);
+                }
             }
-
         }
         ~MPMCQueue() noexcept{
-            for(size_t i = 0; i < buffer_size_; ++i){
-                buffer_[i].~Cell();
+            // Trivially destructible elements need no walk, and cells past the first lap of tail_ were never written
+            if constexpr(!std::is_trivially_destructible_v<T>){
+                const size_t used = std::min(tail_.load(std::memory_order_relaxed), buffer_size_);
+                for(size_t i = 0; i < used; ++i){
+                    buffer_[i].~Cell();
+                }
             }
         }
         MPMCQueue(const MPMCQueue&) = delete;
@@ -275,11 +713,14 @@ static inline bool cas_add(std::atomic<size_t> &seq,size_t val) noexcept{
         requires std::is_constructible_v<T,Args &&...>{
             size_t pos = tail_.fetch_add(1,std::memory_order_relaxed);
             auto &cell = buffer_[pos];
+            const uint64_t wait_start = trace_begin(pos);
             // Wait until the cell is available (sequence matches position)
-            while(pos != cell.seq_.load(std::memory_order_acquire));
+            while(pos != load_seq(cell, pos));
+            trace_wait(pos, wait_start);
             cell.construct(std::forward<Args>(args)...);
+            trace_publish(pos);
             // Mark cell as ready for consumption
-            cell.seq_.store(pos + 1, std::memory_order_release);
+            store_seq(cell, pos, pos + 1);
         }
         void push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>)
         requires std::is_copy_constructible_v<T>{
@@ -297,12 +738,13 @@ static inline bool cas_add(std::atomic<size_t> &seq,size_t val) noexcept{
             while(true){
                 size_t pos = tail_.load(std::memory_order_relaxed);
                 auto &cell = buffer_[pos];
-                const size_t seq = cell.seq_.load(std::memory_order_acquire);
+                const size_t seq = load_seq(cell, pos);
                 const int64_t diff = seq - pos;
                 if (diff == 0 && cas_add(tail_,pos)){
                     // Cell is available and we successfully claimed it
                     cell.construct(std::forward<Args>(args)...);
-                    cell.seq_.store(pos + 1, std::memory_order_release);
+                    trace_publish(pos);
+                    store_seq(cell, pos, pos + 1);
                     return true;
                 }
                 else if (diff < 0){
@@ -323,24 +765,28 @@ static inline bool cas_add(std::atomic<size_t> &seq,size_t val) noexcept{
         void pop(T &value) noexcept{
             const size_t pos = head_.fetch_add(1,std::memory_order_relaxed);
             auto &cell = buffer_[pos];
+            const uint64_t wait_start = trace_begin(pos);
             // Wait until the cell is ready for consumption
-            while(pos + 1 != cell.seq_.load(std::memory_order_acquire));
+            while(pos + 1 != load_seq(cell, pos));
+            trace_wait(pos, wait_start);
+            trace_consume(pos);
             value = cell.read();
             cell.destroy();
             // Mark cell as available for reuse
-            cell.seq_.store(pos + buffer_size_, std::memory_order_release);
+            store_seq(cell, pos, pos + buffer_size_);
         }
         [[nodiscard]] bool try_pop(T &value) noexcept{
             while(true){
                 const size_t pos = head_.load(std::memory_order_relaxed);
                 auto &cell = buffer_[pos];
-                const size_t seq = cell.seq_.load(std::memory_order_acquire);
+                const size_t seq = load_seq(cell, pos);
                 const int64_t diff = seq - pos;
                 if (diff == 1 && cas_add(head_,pos)){
                     // Cell contains data and we successfully claimed it
+                    trace_consume(pos);
                     value = cell.read();
                     cell.destroy();
-                    cell.seq_.store(pos + buffer_size_, std::memory_order_release);
+                    store_seq(cell, pos, pos + buffer_size_);
                     return true;
                 }
                 else if (diff < 1){
@@ -349,6 +795,27 @@ static inline bool cas_add(std::atomic<size_t> &seq,size_t val) noexcept{
                 }
             }
         }
+        // Approximate number of elements, exact only when no push or pop is in flight
+        size_t size() const noexcept{
+            const size_t head = head_.load(std::memory_order_relaxed);
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            const int64_t diff = tail - head;
+            return diff < 0 ? 0 : (size_t(diff) > buffer_size_ ? buffer_size_ : size_t(diff));
+        }
+        size_t capacity() const noexcept{
+            return buffer_size_;
+        }
+        // Zero-page buffers fault pages in on first use, this pays that cost up front across threads
+        // Call before the queue is shared, 0 threads means one per hardware thread
+        void prefault(size_t threads = 0) noexcept
+        requires ZeroPage{
+            buffer_.prefault(threads);
+        }
+        // Per-thread residency and seq_ wait histograms of the sampled messages, in rdtsc ticks
+        std::vector<ThreadLatency> export_trace() const
+        requires Tracing{
+            return tracer_.export_trace();
+        }
     };
     // Single Producer Multiple Consumer queue implementation
     
@@ -357,21 +824,106 @@ static inline bool cas_add(std::atomic<size_t> &seq,size_t val) noexcept{
         size_t N,
         bool Modulo = true,
         IsValidConstraint SizeConstraint = EnablePowerOfTwo,
-        IsValidBufferType BufferType = UseHeapBuffer
+        IsValidBufferType BufferType = UseHeapBuffer,
+        IsValidTracePolicy TracePolicy = DisableTracing
     >
     requires IsValidMPMCQueue<T,N,SizeConstraint>
     class SPMCQueue{
         private:
             static constexpr bool UseStack = std::is_same_v<BufferType,UseStackBuffer>;
+            static constexpr bool ZeroPage = std::is_same_v<BufferType,UseZeroPageBuffer>;
             using value_type = Cell<T,true>;
             using heap_buffer = HeapBuffer<value_type,SizeConstraint,Modulo,N>;
             using stack_buffer = StackBuffer<value_type,N,Modulo>;
+            using zero_page_buffer = ZeroPageBuffer<value_type,SizeConstraint,Modulo,N>;
             using allocator_type = std::allocator<value_type>;
-            using buffer_type = std::conditional_t<UseStack,stack_buffer,heap_buffer>;
+            using buffer_type = std::conditional_t<UseStack,stack_buffer,std::conditional_t<ZeroPage,zero_page_buffer,heap_buffer>>;
             
             alignas(cache_line) buffer_type buffer_;
             alignas(cache_line) const size_t buffer_size_;
             alignas(cache_line) size_t write_idx_; // Single producer doesn't need atomic
+            static constexpr bool Tracing = IsTracingEnabled<TracePolicy>;
+            using tracer_type = QueueTracer<TracePolicy,SizeConstraint,N>;
+            [[no_unique_address]] tracer_type tracer_;
+            // The single producer never waits on seq_, so only residency is traced
+            void trace_publish(size_t pos) noexcept{
+                if constexpr(Tracing){
+                    if(tracer_.sampled(pos)){
+                        tracer_.stamp(pos, rdtsc());
+                    }
+                }
+            }
+            void trace_consume(size_t pos) noexcept{
+                if constexpr(Tracing){
+                    if(tracer_.sampled(pos)){
+                        tracer_.record_residency(pos, rdtsc());
+                    }
+                }
+            }
+            static constexpr size_t idle_member = SIZE_MAX;
+            struct alignas(cache_line) MemberSlot{
+                // Index the member may still be reading, idle_member when it holds nothing
+                std::atomic<size_t> processing_{idle_member};
+            };
+            // Consumer group: members share one claim cursor, so each message goes to one member of the group
+            struct GroupState{
+                alignas(cache_line) std::atomic<size_t> claim_{0}; // next index to hand out
+                alignas(cache_line) std::atomic<size_t> members_{0};
+                std::atomic<uint64_t> missed_{0};                  // overwritten before a lossy group claimed them
+                std::string name_;
+                bool lossless_ = true;
+                MemberSlot slots_[max_group_members];
+            };
+            std::unique_ptr<GroupState[]> groups_; // allocated by the first getGroup(), readers alone pay nothing
+            std::atomic<size_t> group_count_{0};
+            std::atomic<size_t> lossless_groups_{0};
+            std::atomic<size_t> lossy_groups_{0};
+            size_t cached_gate_ = 0; // producer's last view of the slowest lossless group
+
+            // Smallest index any lossless group may still need, claim_ is read before the member slots
+            size_t gate() const noexcept{
+                size_t gate = idle_member;
+                const size_t groups = group_count_.load(std::memory_order_acquire);
+                for(size_t g = 0; g < groups; ++g){
+                    const GroupState &group = groups_[g];
+                    if(!group.lossless_){
+                        continue;
+                    }
+                    const size_t claim = group.claim_.load(std::memory_order_seq_cst);
+                    gate = claim < gate ? claim : gate;
+                    const size_t members = group.members_.load(std::memory_order_acquire);
+                    for(size_t m = 0; m < members; ++m){
+                        const size_t processing = group.slots_[m].processing_.load(std::memory_order_seq_cst);
+                        gate = processing < gate ? processing : gate;
+                    }
+                }
+                return gate;
+            }
+            // pos reuses the cell of pos - buffer_size_, which every lossless group must be done with
+            bool gate_open(size_t pos) noexcept{
+                if(lossless_groups_.load(std::memory_order_relaxed) == 0 || pos < buffer_size_){
+                    return true;
+                }
+                if(pos - buffer_size_ < cached_gate_){
+                    return true;
+                }
+                cached_gate_ = gate();
+                return pos - buffer_size_ < cached_gate_;
+            }
+            template<typename ...Args>
+            void publish(Args &&... args) noexcept(std::is_nothrow_constructible_v<T,Args &&...>) {
+                auto& cell = buffer_[++write_idx_];
+                // Seqlock for lossy members, which may be copying this cell: seq 0 reads as unpublished while
+                // the payload changes, and the fence orders that store before any byte of the new payload
+                if(lossy_groups_.load(std::memory_order_relaxed) != 0){
+                    cell.seq_.store(0, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_release);
+                }
+                cell.construct(std::forward<Args>(args)...);
+                trace_publish(write_idx_);
+                // Make the data visible to readers
+                cell.seq_.store(write_idx_, std::memory_order_release);
+            }
             
         public:
             // Reader class for multiple consumers to track their read position
@@ -382,26 +934,129 @@ static inline bool cas_add(std::atomic<size_t> &seq,size_t val) noexcept{
                     auto& cell = queue_->buffer_[next_idx_];
                     size_t cell_seq = cell.seq_.load(std::memory_order_acquire);
                     if (int64_t(cell_seq - next_idx_) < 0) return nullptr;
+                    queue_->trace_consume(cell_seq);
                     next_idx_ = cell_seq + 1;
                     return &cell.get();
                 }
                 SPMCQueue* queue_ = nullptr;
                 size_t next_idx_;
             };
+            // One thread of a consumer group, obtained from ConsumerGroup::join()
+            struct GroupMember {
+                operator bool() const { return queue_ != nullptr; }
+
+                // Claims the next message of the group if it is already published
+                [[nodiscard]] bool try_read(T &value) noexcept(std::is_nothrow_copy_assignable_v<T>) {
+                    std::atomic<size_t> &processing = group_->slots_[index_].processing_;
+                    while (true) {
+                        size_t idx = group_->claim_.load(std::memory_order_seq_cst);
+                        processing.store(idx, std::memory_order_seq_cst);
+                        auto& cell = queue_->buffer_[idx];
+                        const size_t cell_seq = cell.seq_.load(std::memory_order_acquire);
+                        if (int64_t(cell_seq - idx) < 0) {
+                            processing.store(idle_member, std::memory_order_release);
+                            return false;
+                        }
+                        if (!group_->claim_.compare_exchange_weak(idx, idx + 1, std::memory_order_seq_cst)) {
+                            continue;
+                        }
+                        if (consume(cell, idx, cell_seq, value)) {
+                            return true;
+                        }
+                    }
+                }
+                // Claims the next message with fetch_add and spins until the producer publishes it
+                void read(T &value) noexcept(std::is_nothrow_copy_assignable_v<T>) {
+                    std::atomic<size_t> &processing = group_->slots_[index_].processing_;
+                    while (true) {
+                        // A lower bound of the claim is visible before the claim itself
+                        processing.store(group_->claim_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+                        const size_t idx = group_->claim_.fetch_add(1, std::memory_order_seq_cst);
+                        processing.store(idx, std::memory_order_seq_cst);
+                        auto& cell = queue_->buffer_[idx];
+                        size_t cell_seq;
+                        while (int64_t((cell_seq = cell.seq_.load(std::memory_order_acquire)) - idx) < 0) {
+                            cpu_relax();
+                        }
+                        if (consume(cell, idx, cell_seq, value)) {
+                            return;
+                        }
+                    }
+                }
+                SPMCQueue* queue_ = nullptr;
+                GroupState* group_ = nullptr;
+                size_t index_;
+            private:
+                // Copies the claimed cell, a lossy group detects and skips cells the producer lapped
+                // or is rewriting: any byte of a new payload implies the recheck sees seq 0 or a later index
+                bool consume(value_type &cell, size_t idx, size_t cell_seq, T &value) noexcept(std::is_nothrow_copy_assignable_v<T>) {
+                    std::atomic<size_t> &processing = group_->slots_[index_].processing_;
+                    if (cell_seq == idx) {
+                        value = cell.get();
+                        if (group_->lossless_) {
+                            processing.store(idle_member, std::memory_order_release);
+                            queue_->trace_consume(idx);
+                            return true;
+                        }
+                        std::atomic_thread_fence(std::memory_order_acquire);
+                        if (cell.seq_.load(std::memory_order_relaxed) == idx) {
+                            processing.store(idle_member, std::memory_order_release);
+                            queue_->trace_consume(idx);
+                            return true;
+                        }
+                    }
+                    group_->missed_.fetch_add(1, std::memory_order_relaxed);
+                    processing.store(idle_member, std::memory_order_release);
+                    return false;
+                }
+            };
+            // Named set of members that load-balance one copy of the stream between them
+            struct ConsumerGroup {
+                operator bool() const { return queue_ != nullptr; }
+                // Register the calling thread as a member, returns an empty member when the group is full
+                GroupMember join() noexcept {
+                    GroupMember member;
+                    const size_t index = group_->members_.fetch_add(1, std::memory_order_acq_rel);
+                    if (index >= max_group_members) {
+                        group_->members_.store(max_group_members, std::memory_order_release);
+                        return member;
+                    }
+                    member.queue_ = queue_;
+                    member.group_ = group_;
+                    member.index_ = index;
+                    return member;
+                }
+                std::string_view name() const noexcept { return group_->name_; }
+                bool lossless() const noexcept { return group_->lossless_; }
+                // Messages the producer overwrote before this lossy group claimed them
+                uint64_t missed() const noexcept { return group_->missed_.load(std::memory_order_relaxed); }
+                // Next index the group will hand out, compare across groups to find the slowest
+                size_t cursor() const noexcept { return group_->claim_.load(std::memory_order_relaxed); }
+                SPMCQueue* queue_ = nullptr;
+                GroupState* group_ = nullptr;
+            };
             
             explicit SPMCQueue(const size_t buffer_size = N, const allocator_type &allocator = allocator_type()) noexcept:
             buffer_(buffer_size,allocator),
             buffer_size_(buffer_size),
-            write_idx_(0) {
-                // Initialize all cells
-                for(size_t i = 0; i < buffer_size_; ++i){
-                    new(&buffer_[i]) value_type(i);
+            write_idx_(0),
+            tracer_(buffer_size) {
+                // Initialize all cells, the first published index is 1 so seq 0 means nothing written yet
+                // Zero pages already hold exactly that state
+                if constexpr(!ZeroPage){
+                    for(size_t i = 0; i < buffer_size_; ++i){
+                        new(&buffer_[i]) value_type(0);
+                    }
                 }
             }
             
             ~SPMCQueue() noexcept {
-                for(size_t i = 0; i < buffer_size_; ++i){
-                    buffer_[i].~Cell();
+                // Only cells the producer has reached can hold an element
+                if constexpr(!std::is_trivially_destructible_v<T>){
+                    const size_t used = std::min(write_idx_ + 1, buffer_size_);
+                    for(size_t i = 0; i < used; ++i){
+                        buffer_[i].~Cell();
+                    }
                 }
             }
             
@@ -417,14 +1072,65 @@ static inline bool cas_add(std::atomic<size_t> &seq,size_t val) noexcept{
                 reader.next_idx_ = write_idx_ + 1;
                 return reader;
             }
-            
+            // Find or create a consumer group starting from the current write position
+            // Lossless groups hold the producer back instead of losing messages, the slowest one gates it
+            // Groups are set up before the producer starts, returns an empty group when all are taken
+            // A lossy member copies a cell the producer may be rewriting and checks seq_ afterwards,
+            // which is only safe for trivially copyable T, so lossy groups of other types are refused
+            // Once a lossy group exists every publish marks its cell unpublished before rewriting it
+            ConsumerGroup getGroup(std::string_view name, bool lossless = true) {
+                ConsumerGroup group;
+                if constexpr(!std::is_trivially_copyable_v<T>){
+                    if(!lossless){
+                        return group;
+                    }
+                }
+                if(!groups_){
+                    groups_.reset(new GroupState[max_consumer_groups]);
+                }
+                const size_t count = group_count_.load(std::memory_order_acquire);
+                for(size_t g = 0; g < count; ++g){
+                    if(groups_[g].name_ == name){
+                        group.queue_ = this;
+                        group.group_ = &groups_[g];
+                        return group;
+                    }
+                }
+                if(count == max_consumer_groups){
+                    return group;
+                }
+                GroupState &state = groups_[count];
+                state.name_ = name;
+                state.lossless_ = lossless;
+                state.claim_.store(write_idx_ + 1, std::memory_order_relaxed);
+                group_count_.store(count + 1, std::memory_order_release);
+                if(lossless){
+                    lossless_groups_.fetch_add(1, std::memory_order_relaxed);
+                }else{
+                    lossy_groups_.fetch_add(1, std::memory_order_relaxed);
+                }
+                group.queue_ = this;
+                group.group_ = &state;
+                return group;
+            }
+
+            // Fails only when a lossless group still needs the cell about to be reused
+            template<typename ...Args>
+            [[nodiscard]] bool try_emplace(Args &&... args) noexcept(std::is_nothrow_constructible_v<T,Args &&...>)
+            requires std::is_constructible_v<T,Args &&...> {
+                if(!gate_open(write_idx_ + 1)){
+                    return false;
+                }
+                publish(std::forward<Args>(args)...);
+                return true;
+            }
             template<typename ...Args>
             void emplace(Args &&... args) noexcept(std::is_nothrow_constructible_v<T,Args &&...>)
             requires std::is_constructible_v<T,Args &&...> {
-                auto& cell = buffer_[++write_idx_];
-                cell.construct(std::forward<Args>(args)...);
-                // Make the data visible to readers
-                cell.seq_.store(write_idx_, std::memory_order_release);
+                while(!gate_open(write_idx_ + 1)){
+                    cpu_relax();
+                }
+                publish(std::forward<Args>(args)...);
             }
             void push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>)
             requires std::is_copy_constructible_v<T> {
@@ -436,5 +1142,334 @@ static inline bool cas_add(std::atomic<size_t> &seq,size_t val) noexcept{
             requires std::is_constructible_v<T,P> {
                 emplace(std::forward<P>(value));
             }
+            [[nodiscard]] bool try_push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>)
+            requires std::is_copy_constructible_v<T> {
+                return try_emplace(value);
+            }
+            template<typename P>
+            [[nodiscard]] bool try_push(P &&value) noexcept(std::is_nothrow_constructible_v<T,P>)
+            requires std::is_constructible_v<T,P> {
+                return try_emplace(std::forward<P>(value));
+            }
+            // Zero-page buffers fault pages in on first use, this pays that cost up front across threads
+            // Call before the queue is shared, 0 threads means one per hardware thread
+            void prefault(size_t threads = 0) noexcept
+            requires ZeroPage {
+                buffer_.prefault(threads);
+            }
+            // Per-reader-thread residency histograms of the sampled messages, in rdtsc ticks
+            std::vector<ThreadLatency> export_trace() const
+            requires Tracing {
+                return tracer_.export_trace();
+            }
+    };
+    template<typename T, size_t N, typename SizeConstraint>
+    concept IsValidSPSCQueue = ValidSizeParameter<N,SizeConstraint>;
+    // Single Producer Single Consumer queue implementation
+    // Cells carry no sequence number, the two indices alone order producer and consumer
+    template<
+        typename T,
+        size_t N,
+        bool Modulo = true,
+        IsValidConstraint SizeConstraint = EnablePowerOfTwo,
+        IsValidBufferType BufferType = UseHeapBuffer
+    >
+    requires IsValidSPSCQueue<T,N,SizeConstraint>
+    class SPSCQueue{
+        private:
+            static constexpr bool UseStack = std::is_same_v<BufferType,UseStackBuffer>;
+            static constexpr bool ZeroPage = std::is_same_v<BufferType,UseZeroPageBuffer>;
+            using value_type = Cell<T,false>;
+            using heap_buffer = HeapBuffer<value_type,SizeConstraint,Modulo,N>;
+            using stack_buffer = StackBuffer<value_type,N,Modulo>;
+            using zero_page_buffer = ZeroPageBuffer<value_type,SizeConstraint,Modulo,N>;
+            using allocator_type = std::allocator<value_type>;
+            using buffer_type = std::conditional_t<UseStack,stack_buffer,std::conditional_t<ZeroPage,zero_page_buffer,heap_buffer>>;
+
+            alignas(cache_line) buffer_type buffer_;
+            alignas(cache_line) const size_t buffer_size_;
+            alignas(cache_line) std::atomic<size_t> head_; // Consumer index
+            size_t cached_tail_;                           // Consumer's last view of tail_
+            alignas(cache_line) std::atomic<size_t> tail_; // Producer index
+            size_t cached_head_;                           // Producer's last view of head_
+        public:
+            explicit SPSCQueue(const size_t buffer_size = N, const allocator_type &allocator = allocator_type()) noexcept:
+            buffer_(buffer_size,allocator),
+            buffer_size_(buffer_size),
+            head_(0),
+            cached_tail_(0),
+            tail_(0),
+            cached_head_(0){
+                if constexpr(!ZeroPage){
+                    for(size_t i = 0; i < buffer_size_; ++i){
+                        new(&buffer_[i]) value_type(i);
+                    }
+                }
+            }
+            ~SPSCQueue() noexcept{
+                // Trivially destructible elements need no walk, and cells past the first lap of tail_ were never written
+                if constexpr(!std::is_trivially_destructible_v<T>){
+                    const size_t used = std::min(tail_.load(std::memory_order_relaxed), buffer_size_);
+                    for(size_t i = 0; i < used; ++i){
+                        buffer_[i].~Cell();
+                    }
+                }
+            }
+            SPSCQueue(const SPSCQueue&) = delete;
+            SPSCQueue& operator=(const SPSCQueue&) = delete;
+            SPSCQueue(SPSCQueue&& other) = delete;
+            SPSCQueue& operator=(SPSCQueue&& other) = delete;
+            template<typename... Args>
+            [[nodiscard]] bool try_emplace(Args &&... args) noexcept(std::is_nothrow_constructible_v<T,Args &&...>)
+            requires std::is_constructible_v<T,Args &&...>{
+                const size_t pos = tail_.load(std::memory_order_relaxed);
+                if(pos - cached_head_ == buffer_size_){
+                    // Refresh the consumer index only when the cached one says full
+                    cached_head_ = head_.load(std::memory_order_acquire);
+                    if(pos - cached_head_ == buffer_size_){
+                        return false;
+                    }
+                }
+                buffer_[pos].construct(std::forward<Args>(args)...);
+                tail_.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+            template<typename... Args>
+            void emplace(Args &&... args) noexcept(std::is_nothrow_constructible_v<T,Args &&...>)
+            requires std::is_constructible_v<T,Args &&...>{
+                while(!try_emplace(std::forward<Args>(args)...)){
+                    cpu_relax();
+                }
+            }
+            void push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>)
+            requires std::is_copy_constructible_v<T>{
+                emplace(value);
+            }
+            template<typename P>
+            void push(P &&value) noexcept(std::is_nothrow_constructible_v<T,P>)
+            requires std::is_constructible_v<T,P>{
+                emplace(std::forward<P>(value));
+            }
+            [[nodiscard]] bool try_push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>)
+            requires std::is_copy_constructible_v<T>{
+                return try_emplace(value);
+            }
+            template<typename P>
+            [[nodiscard]] bool try_push(P &&value) noexcept(std::is_nothrow_constructible_v<T,P>)
+            requires std::is_constructible_v<T,P>{
+                return try_emplace(std::forward<P>(value));
+            }
+            [[nodiscard]] bool try_pop(T &value) noexcept{
+                const size_t pos = head_.load(std::memory_order_relaxed);
+                if(pos == cached_tail_){
+                    cached_tail_ = tail_.load(std::memory_order_acquire);
+                    if(pos == cached_tail_){
+                        return false;
+                    }
+                }
+                auto &cell = buffer_[pos];
+                value = cell.read();
+                cell.destroy();
+                head_.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+            void pop(T &value) noexcept{
+                while(!try_pop(value)){
+                    cpu_relax();
+                }
+            }
+            // Approximate number of elements, exact only when called from the producer or consumer
+            size_t size() const noexcept{
+                const size_t head = head_.load(std::memory_order_relaxed);
+                const size_t tail = tail_.load(std::memory_order_relaxed);
+                const int64_t diff = tail - head;
+                return diff < 0 ? 0 : size_t(diff);
+            }
+            size_t capacity() const noexcept{
+                return buffer_size_;
+            }
+            // Zero-page buffers fault pages in on first use, this pays that cost up front across threads
+            // Call before the queue is shared, 0 threads means one per hardware thread
+            void prefault(size_t threads = 0) noexcept
+            requires ZeroPage{
+                buffer_.prefault(threads);
+            }
+    };
+    // 16 byte compare-and-swap, available with -mcx16 on x86-64 and natively on AArch64
+    // FastMPMCQueue resolves differently with and without it, so every translation unit of a program
+    // must agree: build the whole project with -mcx16 (ATOMIC_QUEUE_CX16 in CMake) or with none
+    #if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16) && (defined(__x86_64__) || defined(__aarch64__))
+    static constexpr bool has_cas16 = true;
+    using uint128_alias = unsigned __int128 __attribute__((may_alias));
+    static inline bool cas16(void *target, unsigned __int128 expected, unsigned __int128 desired) noexcept{
+        return __sync_bool_compare_and_swap(static_cast<uint128_alias*>(target), expected, desired);
+    }
+    #else
+    static constexpr bool has_cas16 = false;
+    #endif
+    // Elements small enough to share a 16 byte slot with their sequence number
+    template<typename T>
+    concept IsPackable = IsTrivial<T> && has_cas16;
+    template<typename T, size_t N>
+    concept IsValidPackedMPMCQueue = IsPackable<T> && is_power_of_two(N) && (N > 0);
+    // MPMC queue whose slot is {seq, value} in 16 bytes, so a push or a pop is a single cmpxchg16b on one line
+    // Four slots share a cache line, consecutive positions are remapped onto different lines
+    // Capacity must be a power of two, use FastMPMCQueue to fall back to MPMCQueue automatically
+    template<typename T, size_t N>
+    requires IsValidPackedMPMCQueue<T,N>
+    class PackedMPMCQueue{
+        private:
+            struct alignas(16) Slot{
+                uint64_t seq_;
+                uint64_t value_;
+            };
+            static constexpr size_t slots_per_line = cache_line / sizeof(Slot);
+            // Line-aligned storage, so the slots_per_line slots of a line really share one cache line
+            struct alignas(cache_line) Line{
+                Slot slots_[slots_per_line];
+            };
+            static_assert(sizeof(Line) == cache_line);
+            std::unique_ptr<Line[]> lines_;
+            const size_t buffer_size_;
+            const size_t mask_;
+            const size_t line_shift_; // log2 of the number of lines
+            alignas(cache_line) std::atomic<size_t> head_{0}; // Consumer index
+            alignas(cache_line) std::atomic<size_t> tail_{0}; // Producer index
+
+            static unsigned __int128 pack(uint64_t seq, uint64_t value) noexcept{
+                return (static_cast<unsigned __int128>(value) << 64) | seq;
+            }
+            static uint64_t to_bits(const T &value) noexcept{
+                uint64_t bits = 0;
+                std::memcpy(&bits, &value, sizeof(T));
+                return bits;
+            }
+            static T from_bits(uint64_t bits) noexcept{
+                T value;
+                std::memcpy(&value, &bits, sizeof(T));
+                return value;
+            }
+            // Position to slot, neighbouring positions land on different lines
+            Slot &slot(size_t pos) noexcept{
+                const size_t index = pos & mask_;
+                if(buffer_size_ < slots_per_line){
+                    return lines_[0].slots_[index];
+                }
+                const size_t lines_mask = (buffer_size_ / slots_per_line) - 1;
+                return lines_[index & lines_mask].slots_[index >> line_shift_];
+            }
+            static uint64_t load_seq(Slot &cell) noexcept{
+                return std::atomic_ref<uint64_t>(cell.seq_).load(std::memory_order_acquire);
+            }
+            // A free slot holds {pos, 0}, value and sequence are published by one CAS
+            static void publish(Slot &cell, size_t pos, const T &value) noexcept{
+                const bool published = cas16(&cell, pack(pos, 0), pack(pos + 1, to_bits(value)));
+                assert(published);
+                (void)published;
+            }
+            // Hand the slot to the next lap in the state the constructor leaves it in
+            T release(Slot &cell, size_t pos) noexcept{
+                const uint64_t bits = cell.value_;
+                const bool released = cas16(&cell, pack(pos + 1, bits), pack(pos + buffer_size_, 0));
+                assert(released);
+                (void)released;
+                return from_bits(bits);
+            }
+        public:
+            explicit PackedMPMCQueue(const size_t buffer_size = N):
+            lines_(new Line[(buffer_size + slots_per_line - 1) / slots_per_line]),
+            buffer_size_(buffer_size),
+            mask_(buffer_size - 1),
+            line_shift_(buffer_size < slots_per_line ? 0 : size_t(std::countr_zero(buffer_size / slots_per_line))){
+                assert(is_power_of_two(buffer_size));
+                for(size_t i = 0; i < buffer_size_; ++i){
+                    slot(i) = Slot{i, 0};
+                }
+            }
+            PackedMPMCQueue(const PackedMPMCQueue&) = delete;
+            PackedMPMCQueue& operator=(const PackedMPMCQueue&) = delete;
+            PackedMPMCQueue(PackedMPMCQueue&& other) = delete;
+            PackedMPMCQueue& operator=(PackedMPMCQueue&& other) = delete;
+
+            void push(const T &value) noexcept{
+                const size_t pos = tail_.fetch_add(1, std::memory_order_relaxed);
+                Slot &cell = slot(pos);
+                // Spin on a plain load, the position is ours so the CAS cannot fail once the slot is free
+                while(load_seq(cell) != pos){
+                    cpu_relax();
+                }
+                publish(cell, pos, value);
+            }
+            [[nodiscard]] bool try_push(const T &value) noexcept{
+                size_t pos = tail_.load(std::memory_order_relaxed);
+                while(true){
+                    Slot &cell = slot(pos);
+                    const int64_t diff = int64_t(load_seq(cell) - pos);
+                    if(diff == 0){
+                        if(cas_add(tail_, pos)){
+                            publish(cell, pos, value);
+                            return true;
+                        }
+                    }else if(diff < 0){
+                        return false;
+                    }
+                    pos = tail_.load(std::memory_order_relaxed);
+                }
+            }
+            template<typename ...Args>
+            void emplace(Args &&... args) noexcept
+            requires std::is_constructible_v<T,Args &&...>{
+                push(T(std::forward<Args>(args)...));
+            }
+            template<typename ...Args>
+            [[nodiscard]] bool try_emplace(Args &&... args) noexcept
+            requires std::is_constructible_v<T,Args &&...>{
+                return try_push(T(std::forward<Args>(args)...));
+            }
+            void pop(T &value) noexcept{
+                const size_t pos = head_.fetch_add(1, std::memory_order_relaxed);
+                Slot &cell = slot(pos);
+                while(load_seq(cell) != pos + 1){
+                    cpu_relax();
+                }
+                value = release(cell, pos);
+            }
+            [[nodiscard]] bool try_pop(T &value) noexcept{
+                size_t pos = head_.load(std::memory_order_relaxed);
+                while(true){
+                    Slot &cell = slot(pos);
+                    const int64_t diff = int64_t(load_seq(cell) - (pos + 1));
+                    if(diff == 0){
+                        if(cas_add(head_, pos)){
+                            value = release(cell, pos);
+                            return true;
+                        }
+                    }else if(diff < 0){
+                        return false;
+                    }
+                    pos = head_.load(std::memory_order_relaxed);
+                }
+            }
+            // Approximate number of elements, exact only when no push or pop is in flight
+            size_t size() const noexcept{
+                const size_t head = head_.load(std::memory_order_relaxed);
+                const size_t tail = tail_.load(std::memory_order_relaxed);
+                const int64_t diff = tail - head;
+                return diff < 0 ? 0 : (size_t(diff) > buffer_size_ ? buffer_size_ : size_t(diff));
+            }
+            size_t capacity() const noexcept{
+                return buffer_size_;
+            }
+    };
+    // PackedMPMCQueue when T fits a 16 byte slot and the target has cmpxchg16b, MPMCQueue otherwise
+    template<typename T, size_t N, bool Packed = IsValidPackedMPMCQueue<T,N>>
+    struct SelectMPMCQueue{
+        using type = MPMCQueue<T,N>;
+    };
+    template<typename T, size_t N>
+    struct SelectMPMCQueue<T,N,true>{
+        using type = PackedMPMCQueue<T,N>;
     };
+    template<typename T, size_t N>
+    using FastMPMCQueue = typename SelectMPMCQueue<T,N>::type;
 }
@@ -0,0 +1,333 @@
+#pragma once
+// Delay queue: elements become visible to the consumer once their deadline has passed
+// Producers schedule and cancel lock-free, the consumer owns a hierarchical timing wheel
+
+#include "atomic_queue.hpp"
+#include <chrono>
+#include <limits>
+#include <new>
+
+namespace sl{
+    // Handle returned by schedule, stays valid for cancel until the timer fires or is cancelled
+    struct TimerId{
+        uint32_t index_ = std::numeric_limits<uint32_t>::max();
+        uint64_t generation_ = 0;
+        operator bool() const { return index_ != std::numeric_limits<uint32_t>::max(); }
+    };
+    // Many producers schedule and cancel, exactly one consumer pops
+    // Deadlines are rounded up to whole ticks, so an element is never delivered early and at most one tick late
+    // Capacity bounds the pending timers, a cancelled timer holds its node until the consumer next reaches it
+    template<typename T, size_t Capacity = 65536>
+    requires (Capacity > 0) && (Capacity < std::numeric_limits<uint32_t>::max())
+    class DelayQueue{
+        public:
+            using clock = std::chrono::steady_clock;
+            using time_point = clock::time_point;
+        private:
+            static constexpr uint32_t nil = std::numeric_limits<uint32_t>::max();
+            static constexpr size_t levels = 4;
+            static constexpr size_t slot_bits = 8;
+            static constexpr size_t slots = size_t(1) << slot_bits;
+            static constexpr uint64_t slot_mask = slots - 1;
+            static constexpr uint64_t horizon = (uint64_t(1) << (levels * slot_bits)) - 1; // in ticks
+            // Node state is generation << 2 | status, cancel and fire race on one CAS
+            static constexpr uint64_t status_free = 0;
+            static constexpr uint64_t status_pending = 1;
+            static constexpr uint64_t status_cancelled = 2;
+            struct Node{
+                std::atomic<uint64_t> state_{status_free};
+                std::atomic<uint32_t> next_{nil}; // free stack, inbox or wheel link, one at a time
+                uint64_t deadline_ = 0;           // in ticks since origin_
+                alignas(T) std::byte storage_[sizeof(T)];
+                T &value() noexcept{ return *std::launder(reinterpret_cast<T*>(storage_)); }
+            };
+            // Intrusive singly linked list, used as a wheel bucket by the consumer alone
+            struct TimerList{
+                uint32_t head_ = nil;
+            };
+            std::unique_ptr<Node[]> nodes_;
+            const std::chrono::nanoseconds tick_;
+            const time_point origin_;
+            // Free nodes, ABA safe through the 32 bit tag above the index
+            alignas(cache_line) std::atomic<uint64_t> free_{nil};
+            // MPSC inbox, producers push and the consumer takes the whole list at once
+            alignas(cache_line) std::atomic<uint32_t> inbox_{nil};
+            // Consumer state
+            alignas(cache_line) uint64_t current_ = 0; // last tick processed
+            std::array<TimerList, levels * slots> wheel_;
+            std::array<std::array<uint64_t, slots / 64>, levels> occupied_{}; // non-empty buckets per level
+            uint32_t ready_head_ = nil;
+            uint32_t ready_tail_ = nil;
+
+            static uint64_t generation_of(uint64_t state) noexcept{ return state >> 2; }
+            static uint64_t status_of(uint64_t state) noexcept{ return state & 3; }
+
+            uint32_t acquire_node() noexcept{
+                uint64_t head = free_.load(std::memory_order_acquire);
+                while(true){
+                    const uint32_t index = static_cast<uint32_t>(head);
+                    if(index == nil){
+                        return nil;
+                    }
+                    const uint32_t next = nodes_[index].next_.load(std::memory_order_relaxed);
+                    const uint64_t replacement = (((head >> 32) + 1) << 32) | next;
+                    if(free_.compare_exchange_weak(head, replacement, std::memory_order_acquire, std::memory_order_acquire)){
+                        return index;
+                    }
+                }
+            }
+            // Consumer only: destroy the value and hand the node back with a new generation
+            void release_node(uint32_t index) noexcept{
+                Node &node = nodes_[index];
+                const uint64_t state = node.state_.load(std::memory_order_relaxed);
+                node.value().~T();
+                node.state_.store(((generation_of(state) + 1) << 2) | status_free, std::memory_order_relaxed);
+                uint64_t head = free_.load(std::memory_order_relaxed);
+                do{
+                    node.next_.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+                }while(!free_.compare_exchange_weak(head, (((head >> 32) + 1) << 32) | index,
+                                                    std::memory_order_release, std::memory_order_relaxed));
+            }
+            bool cancelled(uint32_t index) const noexcept{
+                return status_of(nodes_[index].state_.load(std::memory_order_acquire)) == status_cancelled;
+            }
+            void push_ready(uint32_t index) noexcept{
+                nodes_[index].next_.store(nil, std::memory_order_relaxed);
+                if(ready_tail_ == nil){
+                    ready_head_ = index;
+                }else{
+                    nodes_[ready_tail_].next_.store(index, std::memory_order_relaxed);
+                }
+                ready_tail_ = index;
+            }
+            // Place a node relative to current_, level L holds deadlines less than 256^(L+1) ticks away
+            void file(uint32_t index) noexcept{
+                if(cancelled(index)){
+                    release_node(index);
+                    return;
+                }
+                Node &node = nodes_[index];
+                if(node.deadline_ <= current_){
+                    push_ready(index);
+                    return;
+                }
+                // Beyond the horizon the node parks in the top level and is refiled when that bucket cascades
+                const uint64_t delta = std::min(node.deadline_ - current_, horizon);
+                const size_t level = std::min(size_t(std::bit_width(delta) - 1) / slot_bits, levels - 1);
+                const size_t slot = ((current_ + delta) >> (level * slot_bits)) & slot_mask;
+                TimerList &bucket = wheel_[level * slots + slot];
+                node.next_.store(bucket.head_, std::memory_order_relaxed);
+                bucket.head_ = index;
+                occupied_[level][slot / 64] |= uint64_t(1) << (slot % 64);
+            }
+            uint32_t detach(size_t level, size_t slot) noexcept{
+                TimerList &bucket = wheel_[level * slots + slot];
+                const uint32_t head = bucket.head_;
+                bucket.head_ = nil;
+                occupied_[level][slot / 64] &= ~(uint64_t(1) << (slot % 64));
+                return head;
+            }
+            void refile(uint32_t index) noexcept{
+                while(index != nil){
+                    const uint32_t next = nodes_[index].next_.load(std::memory_order_relaxed);
+                    file(index);
+                    index = next;
+                }
+            }
+            // First non-empty bucket of `level` at or after `from`, slots when none
+            size_t next_occupied(size_t level, size_t from) const noexcept{
+                for(size_t word = from / 64; word < occupied_[level].size(); ++word){
+                    uint64_t bits = occupied_[level][word];
+                    if(word == from / 64){
+                        bits &= ~uint64_t(0) << (from % 64);
+                    }
+                    if(bits){
+                        return word * 64 + size_t(std::countr_zero(bits));
+                    }
+                }
+                return slots;
+            }
+            // Earliest tick after current_ at which a non-empty bucket is due, level 0 buckets fire and higher ones cascade
+            uint64_t next_event() const noexcept{
+                uint64_t event = std::numeric_limits<uint64_t>::max();
+                for(size_t level = 0; level < levels; ++level){
+                    const size_t shift = level * slot_bits;
+                    const size_t span = shift + slot_bits;
+                    const size_t digit = size_t(current_ >> shift) & slot_mask;
+                    uint64_t base = (current_ >> span) << span;
+                    size_t slot = next_occupied(level, digit + 1);
+                    if(slot == slots){
+                        // Wrap to the next rotation of this level
+                        slot = next_occupied(level, 0);
+                        if(slot == slots){
+                            continue;
+                        }
+                        base += uint64_t(1) << span;
+                    }
+                    event = std::min(event, base + (uint64_t(slot) << shift));
+                }
+                return event;
+            }
+            // Move current_ to target, jumping straight to the next due bucket and cascading higher levels at their boundaries
+            void advance(uint64_t target) noexcept{
+                while(current_ < target){
+                    const uint64_t next = current_ + 1;
+                    if((next & slot_mask) == 0){
+                        current_ = next;
+                        for(size_t level = levels - 1; level > 0; --level){
+                            if((next & ((uint64_t(1) << (level * slot_bits)) - 1)) == 0){
+                                refile(detach(level, (next >> (level * slot_bits)) & slot_mask));
+                            }
+                        }
+                        refile(detach(0, 0));
+                        continue;
+                    }
+                    const uint64_t event = next_event();
+                    if(event > target){
+                        current_ = target;
+                    }else if(event & slot_mask){
+                        current_ = event;
+                        refile(detach(0, event & slot_mask));
+                    }else{
+                        // Boundaries are handled above so every due level cascades
+                        current_ = event - 1;
+                    }
+                }
+            }
+            uint64_t ticks_since_origin(time_point when, bool round_up) const noexcept{
+                const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(when - origin_).count();
+                if(ns <= 0){
+                    return 0;
+                }
+                const uint64_t tick = uint64_t(tick_.count());
+                return round_up ? (uint64_t(ns) + tick - 1) / tick : uint64_t(ns) / tick;
+            }
+            // Bring in new timers and everything due by `now`
+            void collect(time_point now) noexcept{
+                uint32_t index = inbox_.exchange(nil, std::memory_order_acquire);
+                // The inbox is LIFO, reverse it so equal deadlines keep their scheduling order
+                uint32_t reversed = nil;
+                while(index != nil){
+                    const uint32_t next = nodes_[index].next_.load(std::memory_order_relaxed);
+                    nodes_[index].next_.store(reversed, std::memory_order_relaxed);
+                    reversed = index;
+                    index = next;
+                }
+                refile(reversed);
+                advance(ticks_since_origin(now, false));
+            }
+            // Next ready node that wins the race against cancel, nil when none
+            uint32_t take_ready() noexcept{
+                while(ready_head_ != nil){
+                    const uint32_t index = ready_head_;
+                    ready_head_ = nodes_[index].next_.load(std::memory_order_relaxed);
+                    if(ready_head_ == nil){
+                        ready_tail_ = nil;
+                    }
+                    Node &node = nodes_[index];
+                    uint64_t state = node.state_.load(std::memory_order_relaxed);
+                    // Pending -> free of the same generation fences off a late cancel
+                    if(status_of(state) == status_pending &&
+                       node.state_.compare_exchange_strong(state, (generation_of(state) << 2) | status_free, std::memory_order_acq_rel)){
+                        return index;
+                    }
+                    release_node(index);
+                }
+                return nil;
+            }
+        public:
+            explicit DelayQueue(std::chrono::nanoseconds tick = std::chrono::milliseconds(1), time_point origin = clock::now()):
+            nodes_(new Node[Capacity]),
+            tick_(tick.count() > 0 ? tick : std::chrono::nanoseconds(1)),
+            origin_(origin){
+                for(size_t i = 0; i < Capacity; ++i){
+                    nodes_[i].next_.store(i + 1 < Capacity ? uint32_t(i + 1) : nil, std::memory_order_relaxed);
+                }
+                free_.store(0, std::memory_order_release);
+            }
+            ~DelayQueue() noexcept{
+                if constexpr(!std::is_trivially_destructible_v<T>){
+                    for(size_t i = 0; i < Capacity; ++i){
+                        if(status_of(nodes_[i].state_.load(std::memory_order_relaxed)) != status_free){
+                            nodes_[i].value().~T();
+                        }
+                    }
+                }
+            }
+            DelayQueue(const DelayQueue&) = delete;
+            DelayQueue& operator=(const DelayQueue&) = delete;
+            DelayQueue(DelayQueue&& other) = delete;
+            DelayQueue& operator=(DelayQueue&& other) = delete;
+
+            // O(1): one free stack pop and one inbox push, an empty TimerId when all nodes are pending
+            template<typename ...Args>
+            [[nodiscard]] TimerId schedule_at(time_point deadline, Args &&... args) noexcept(std::is_nothrow_constructible_v<T,Args &&...>)
+            requires std::is_constructible_v<T,Args &&...>{
+                const uint32_t index = acquire_node();
+                if(index == nil){
+                    return TimerId{};
+                }
+                Node &node = nodes_[index];
+                new(node.storage_) T(std::forward<Args>(args)...);
+                node.deadline_ = ticks_since_origin(deadline, true);
+                const uint64_t generation = generation_of(node.state_.load(std::memory_order_relaxed));
+                node.state_.store((generation << 2) | status_pending, std::memory_order_relaxed);
+                uint32_t head = inbox_.load(std::memory_order_relaxed);
+                do{
+                    node.next_.store(head, std::memory_order_relaxed);
+                }while(!inbox_.compare_exchange_weak(head, index, std::memory_order_release, std::memory_order_relaxed));
+                return TimerId{index, generation};
+            }
+            template<typename Rep, typename Period, typename ...Args>
+            [[nodiscard]] TimerId schedule_after(std::chrono::duration<Rep,Period> delay, Args &&... args) noexcept(std::is_nothrow_constructible_v<T,Args &&...>)
+            requires std::is_constructible_v<T,Args &&...>{
+                return schedule_at(clock::now() + std::chrono::duration_cast<clock::duration>(delay), std::forward<Args>(args)...);
+            }
+            // O(1), any thread; false once the timer has fired, was cancelled or the id is stale
+            bool cancel(TimerId id) noexcept{
+                if(!id || id.index_ >= Capacity){
+                    return false;
+                }
+                uint64_t expected = (id.generation_ << 2) | status_pending;
+                return nodes_[id.index_].state_.compare_exchange_strong(expected, (id.generation_ << 2) | status_cancelled,
+                                                                      std::memory_order_acq_rel);
+            }
+            // Consumer only: pop one element whose deadline is at or before `now`
+            [[nodiscard]] bool try_pop(T &value, time_point now = clock::now()) noexcept{
+                if(ready_head_ == nil){
+                    collect(now);
+                }
+                const uint32_t index = take_ready();
+                if(index == nil){
+                    return false;
+                }
+                value = std::move(nodes_[index].value());
+                release_node(index);
+                return true;
+            }
+            // Consumer only: hand up to `max` expired elements to handler(T&&), returns how many
+            template<typename F>
+            requires std::invocable<F&, T&&>
+            size_t poll(F &&handler, size_t max = std::numeric_limits<size_t>::max(), time_point now = clock::now()){
+                collect(now);
+                size_t count = 0;
+                uint32_t index;
+                while(count < max && (index = take_ready()) != nil){
+                    handler(std::move(nodes_[index].value()));
+                    release_node(index);
+                    ++count;
+                }
+                return count;
+            }
+            // Tick the consumer has processed up to, in ticks since construction
+            uint64_t current_tick() const noexcept{
+                return current_;
+            }
+            std::chrono::nanoseconds tick() const noexcept{
+                return tick_;
+            }
+            size_t capacity() const noexcept{
+                return Capacity;
+            }
+    };
+}
@@ -0,0 +1,172 @@
+#pragma once
+// Allocation-free object pool for pointer-passing queues
+// Every producer owns a cache aligned slab, consumers hand objects back through SPSC return rings
+
+#include "atomic_queue.hpp"
+#include <cstring>
+#include <vector>
+
+namespace sl{
+    struct PoolStats{
+        size_t producer_;
+        size_t capacity_;
+        uint64_t acquired_;
+        uint64_t exhausted_;  // acquire calls that found no free object
+        uint64_t reclaimed_;  // objects pulled back from the return rings
+        size_t free_;         // objects on the producer's free list at its last reclaim
+    };
+    // Objects are constructed on acquire and destroyed on release, the storage never goes back to the allocator
+    // Each ring connects one consumer to one producer, a ring holds a whole slab so release never blocks
+    template<typename T, size_t SlabSize = 1024>
+    requires ValidSizeParameter<SlabSize,EnablePowerOfTwo> && (SlabSize > 0)
+    class MessagePool{
+        private:
+            struct alignas(alignof(T) > cache_line ? alignof(T) : cache_line) Slot{
+                alignas(T) std::byte storage_[sizeof(T)];
+                uint32_t owner_;
+            };
+            static_assert(std::is_standard_layout_v<Slot>, "offsetof on Slot must be well defined");
+            static_assert(offsetof(Slot, storage_) == 0, "object pointer must convert back to its slot");
+            using ring_type = SPSCQueue<Slot*,SlabSize>;
+            struct alignas(cache_line) ProducerState{
+                std::unique_ptr<Slot[]> slab_;
+                std::unique_ptr<Slot*[]> free_;
+                size_t free_count_ = 0;
+                std::vector<std::unique_ptr<ring_type>> returns_; // indexed by consumer
+                // Written by the owning producer only, read by stats()
+                std::atomic<uint64_t> acquired_{0};
+                std::atomic<uint64_t> exhausted_{0};
+                std::atomic<uint64_t> reclaimed_{0};
+                std::atomic<size_t> free_seen_{0};
+            };
+            const size_t consumers_;
+            std::unique_ptr<ProducerState[]> producers_;
+            const size_t producer_count_;
+
+            static void bump(std::atomic<uint64_t> &counter, uint64_t by = 1) noexcept{
+                counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+            }
+            // T lives in storage_, step back from the storage to the Slot object that holds it
+            static Slot *slot_of(T *object) noexcept{
+                std::byte *storage = reinterpret_cast<std::byte*>(object);
+                return std::launder(reinterpret_cast<Slot*>(storage - offsetof(Slot, storage_)));
+            }
+        public:
+            MessagePool(const size_t producers, const size_t consumers):
+            consumers_(consumers == 0 ? 1 : consumers),
+            producers_(new ProducerState[producers == 0 ? 1 : producers]),
+            producer_count_(producers == 0 ? 1 : producers){
+                for(size_t p = 0; p < producer_count_; ++p){
+                    ProducerState &state = producers_[p];
+                    state.slab_.reset(new Slot[SlabSize]);
+                    state.free_.reset(new Slot*[SlabSize]);
+                    // Touch the slab once so the first acquires do not page fault
+                    std::memset(static_cast<void*>(state.slab_.get()), 0, sizeof(Slot) * SlabSize);
+                    for(size_t i = 0; i < SlabSize; ++i){
+                        state.slab_[i].owner_ = static_cast<uint32_t>(p);
+                        state.free_[i] = &state.slab_[SlabSize - 1 - i];
+                    }
+                    state.free_count_ = SlabSize;
+                    state.free_seen_.store(SlabSize, std::memory_order_relaxed);
+                    state.returns_.reserve(consumers_);
+                    for(size_t c = 0; c < consumers_; ++c){
+                        state.returns_.push_back(std::make_unique<ring_type>());
+                    }
+                }
+            }
+            // Every acquired object must be released before the pool is destroyed
+            ~MessagePool() noexcept = default;
+            MessagePool(const MessagePool&) = delete;
+            MessagePool& operator=(const MessagePool&) = delete;
+            MessagePool(MessagePool&& other) = delete;
+            MessagePool& operator=(MessagePool&& other) = delete;
+
+            // Handle used by exactly one producer thread
+            struct Producer{
+                operator bool() const { return pool_ != nullptr; }
+                // Returns nullptr when the slab and the return rings are all empty
+                template<typename ...Args>
+                [[nodiscard]] T* acquire(Args &&... args) noexcept(std::is_nothrow_constructible_v<T,Args &&...>)
+                requires std::is_constructible_v<T,Args &&...>{
+                    ProducerState &state = pool_->producers_[index_];
+                    if(state.free_count_ == 0){
+                        reclaim();
+                        if(state.free_count_ == 0){
+                            bump(state.exhausted_);
+                            return nullptr;
+                        }
+                    }
+                    Slot *slot = state.free_[--state.free_count_];
+                    T *object = new(slot->storage_) T(std::forward<Args>(args)...);
+                    bump(state.acquired_);
+                    return object;
+                }
+                // Pull everything the consumers have handed back onto the free list
+                size_t reclaim() noexcept{
+                    ProducerState &state = pool_->producers_[index_];
+                    size_t reclaimed = 0;
+                    Slot *slot;
+                    for(auto &ring : state.returns_){
+                        while(ring->try_pop(slot)){
+                            state.free_[state.free_count_++] = slot;
+                            ++reclaimed;
+                        }
+                    }
+                    bump(state.reclaimed_, reclaimed);
+                    state.free_seen_.store(state.free_count_, std::memory_order_relaxed);
+                    return reclaimed;
+                }
+                MessagePool* pool_ = nullptr;
+                size_t index_;
+            };
+            // Handle used by exactly one consumer thread
+            struct Consumer{
+                operator bool() const { return pool_ != nullptr; }
+                // Destroys the object and sends its slot back to the producer that acquired it
+                void release(T *object) noexcept{
+                    Slot *slot = slot_of(object);
+                    object->~T();
+                    auto &ring = *pool_->producers_[slot->owner_].returns_[index_];
+                    // A ring holds a whole slab, so the push can only fail on a double release
+                    const bool returned = ring.try_push(slot);
+                    assert(returned);
+                    (void)returned;
+                }
+                MessagePool* pool_ = nullptr;
+                size_t index_;
+            };
+            Producer getProducer(const size_t index) noexcept{
+                Producer producer;
+                producer.pool_ = index < producer_count_ ? this : nullptr;
+                producer.index_ = index;
+                return producer;
+            }
+            Consumer getConsumer(const size_t index) noexcept{
+                Consumer consumer;
+                consumer.pool_ = index < consumers_ ? this : nullptr;
+                consumer.index_ = index;
+                return consumer;
+            }
+            size_t producers() const noexcept{
+                return producer_count_;
+            }
+            size_t consumers() const noexcept{
+                return consumers_;
+            }
+            std::vector<PoolStats> stats() const{
+                std::vector<PoolStats> result;
+                result.reserve(producer_count_);
+                for(size_t p = 0; p < producer_count_; ++p){
+                    const ProducerState &state = producers_[p];
+                    result.push_back(PoolStats{
+                        p,
+                        SlabSize,
+                        state.acquired_.load(std::memory_order_relaxed),
+                        state.exhausted_.load(std::memory_order_relaxed),
+                        state.reclaimed_.load(std::memory_order_relaxed),
+                        state.free_seen_.load(std::memory_order_relaxed)});
+                }
+                return result;
+            }
+    };
+}
@@ -0,0 +1,252 @@
+#pragma once
+// Heterogeneous message queue: each message is stored inline in as many cache line slots as its type needs
+// Consumers dispatch on a compact type index through a compile-time jump table, no allocation and no virtual calls
+
+#include "atomic_queue.hpp"
+#include <array>
+#include <new>
+
+namespace sl{
+    // Builds one handler out of several lambdas, for MessageQueue::pop
+    template<typename ...Fs>
+    struct Overloaded : Fs...{
+        using Fs::operator()...;
+    };
+    template<typename ...Fs>
+    Overloaded(Fs...) -> Overloaded<Fs...>;
+
+    // Number of cache line slots a message of type T occupies
+    template<typename T>
+    inline constexpr size_t message_slots = (sizeof(T) + cache_line - 1) / cache_line;
+    template<typename T, typename ...Ts>
+    inline constexpr size_t message_type_count = (size_t(std::is_same_v<T,Ts>) + ... + 0);
+    template<typename T>
+    concept IsMessage = std::is_nothrow_destructible_v<T> && (alignof(T) <= cache_line)
+                        && (message_slots<T> > 0) && (message_slots<T> < 0x8000);
+    // Every alternative appears once, so the type index of a message is unambiguous
+    template<typename ...Ts>
+    concept IsValidMessageList = (sizeof...(Ts) > 0) && (sizeof...(Ts) <= 0x10000)
+                                 && (IsMessage<Ts> && ...) && ((message_type_count<Ts,Ts...> == 1) && ...);
+
+    // MPMC queue of Ts..., a message takes message_slots<T> consecutive slots instead of the largest alternative
+    // Slot states are {seq, slots << 16 | type} in 16 bytes, remapped like PackedMPMCQueue so neighbours share no line
+    // A message that would wrap starts at slot 0 instead, the skipped slots belong to its record
+    // The handler runs on the message in place, the slots go back to producers when it returns
+    template<typename ...Ts>
+    requires IsValidMessageList<Ts...>
+    class MessageQueue{
+        private:
+            struct alignas(16) State{
+                std::atomic<uint64_t> seq_;
+                std::atomic<uint32_t> info_; // record slots << 16 | type index
+            };
+            struct alignas(cache_line) Line{
+                std::byte bytes_[cache_line];
+            };
+            static constexpr size_t states_per_line = cache_line / sizeof(State);
+            // Line-aligned storage, so the states_per_line states of a line really share one cache line
+            struct alignas(cache_line) StateLine{
+                State states_[states_per_line];
+            };
+            static_assert(sizeof(StateLine) == cache_line);
+            static constexpr size_t max_slots = std::max({message_slots<Ts>...});
+            static constexpr bool trivial_messages = (std::is_trivially_destructible_v<Ts> && ...);
+            std::unique_ptr<StateLine[]> states_;
+            std::unique_ptr<Line[]> lines_;
+            const size_t buffer_size_;
+            const size_t mask_;
+            const size_t line_shift_; // log2 of the number of state lines
+            alignas(cache_line) std::atomic<size_t> head_{0}; // Consumer index
+            alignas(cache_line) std::atomic<size_t> tail_{0}; // Producer index
+
+            template<typename T>
+            static constexpr uint32_t index_of() noexcept{
+                uint32_t index = 0;
+                ((std::is_same_v<T,Ts> ? false : (++index, true)) && ...);
+                return index;
+            }
+            // Position to state, neighbouring positions land on different lines
+            State &state(size_t pos) noexcept{
+                const size_t index = pos & mask_;
+                if(buffer_size_ < states_per_line){
+                    return states_[0].states_[index];
+                }
+                const size_t lines_mask = (buffer_size_ / states_per_line) - 1;
+                return states_[index & lines_mask].states_[index >> line_shift_];
+            }
+            // A message spans consecutive lines, so address the buffer as bytes rather than as one Line
+            std::byte *line(size_t pos) noexcept{
+                return reinterpret_cast<std::byte*>(lines_.get()) + (pos & mask_) * cache_line;
+            }
+            // Slots skipped so a message of this many slots starting at pos does not wrap
+            size_t skip_for(size_t pos, size_t slots) const noexcept{
+                const size_t index = pos & mask_;
+                return index + slots > buffer_size_ ? buffer_size_ - index : 0;
+            }
+            bool is_free(size_t pos, size_t count, int64_t &diff) noexcept{
+                for(size_t i = 0; i < count; ++i){
+                    diff = int64_t(state(pos + i).seq_.load(std::memory_order_acquire) - (pos + i));
+                    if(diff != 0){
+                        return false;
+                    }
+                }
+                return true;
+            }
+            // The record's slots are owned by the caller, write the message and publish the first state
+            template<typename T, typename ...Args>
+            void publish(size_t pos, size_t skip, Args &&... args) noexcept{
+                new (line(pos + skip)) T(std::forward<Args>(args)...);
+                State &first = state(pos);
+                first.info_.store(uint32_t((skip + message_slots<T>) << 16) | index_of<T>(), std::memory_order_relaxed);
+                first.seq_.store(pos + 1, std::memory_order_release);
+            }
+            // Hand every slot of the record to the next lap
+            void release(size_t pos, size_t slots) noexcept{
+                for(size_t i = 0; i < slots; ++i){
+                    state(pos + i).seq_.store(pos + i + buffer_size_, std::memory_order_release);
+                }
+            }
+            // Slots the message of a type index occupies, without the slots its record skipped at the end of the ring
+            static constexpr size_t slots_of(uint32_t type) noexcept{
+                constexpr std::array<size_t, sizeof...(Ts)> slots{message_slots<Ts>...};
+                return slots[type];
+            }
+            template<typename F, typename T>
+            static void invoke(std::byte *bytes, F &handler) noexcept{
+                T &message = *std::launder(reinterpret_cast<T*>(bytes));
+                handler(message);
+                std::destroy_at(&message);
+            }
+            template<typename F>
+            static constexpr std::array<void(*)(std::byte*, F&) noexcept, sizeof...(Ts)> jump_table{&invoke<F,Ts>...};
+            template<typename T>
+            static void destroy(std::byte *bytes) noexcept{
+                std::destroy_at(std::launder(reinterpret_cast<T*>(bytes)));
+            }
+            static constexpr std::array<void(*)(std::byte*) noexcept, sizeof...(Ts)> destroy_table{&destroy<Ts>...};
+            // Masking needs a power of two, and emplace can only make progress if two of the largest message fit
+            static constexpr size_t ring_size(size_t requested) noexcept{
+                return std::bit_ceil(std::max(requested, 2 * max_slots));
+            }
+        public:
+            // Capacity is in slots, rounded up to a power of two with room for two of the largest message
+            explicit MessageQueue(const size_t buffer_size = 4096):
+            states_(new StateLine[(ring_size(buffer_size) + states_per_line - 1) / states_per_line]),
+            lines_(new Line[ring_size(buffer_size)]),
+            buffer_size_(ring_size(buffer_size)),
+            mask_(buffer_size_ - 1),
+            line_shift_(buffer_size_ < states_per_line ? 0 : size_t(std::countr_zero(buffer_size_ / states_per_line))){
+                for(size_t i = 0; i < buffer_size_; ++i){
+                    state(i).seq_.store(i, std::memory_order_relaxed);
+                    state(i).info_.store(0, std::memory_order_relaxed);
+                }
+            }
+            ~MessageQueue() noexcept{
+                if constexpr(!trivial_messages){
+                    size_t pos = head_.load(std::memory_order_relaxed);
+                    while(state(pos).seq_.load(std::memory_order_relaxed) == pos + 1){
+                        const uint32_t info = state(pos).info_.load(std::memory_order_relaxed);
+                        const size_t slots = info >> 16;
+                        const size_t skip = slots - slots_of(info & 0xffff);
+                        destroy_table[info & 0xffff](line(pos + skip));
+                        pos += slots;
+                    }
+                }
+            }
+            MessageQueue(const MessageQueue&) = delete;
+            MessageQueue& operator=(const MessageQueue&) = delete;
+            MessageQueue(MessageQueue&& other) = delete;
+            MessageQueue& operator=(MessageQueue&& other) = delete;
+
+            template<typename T, typename ...Args>
+            void emplace(Args &&... args) noexcept
+            requires (message_type_count<T,Ts...> == 1) && std::is_nothrow_constructible_v<T,Args &&...>{
+                constexpr size_t slots = message_slots<T>;
+                size_t pos = tail_.load(std::memory_order_relaxed);
+                size_t skip = skip_for(pos, slots);
+                while(!tail_.compare_exchange_weak(pos, pos + skip + slots, std::memory_order_relaxed, std::memory_order_relaxed)){
+                    skip = skip_for(pos, slots);
+                }
+                // The positions are ours, wait for consumers of the previous lap to hand back each slot
+                for(size_t i = 0; i < skip + slots; ++i){
+                    State &s = state(pos + i);
+                    while(s.seq_.load(std::memory_order_acquire) != pos + i){
+                        cpu_relax();
+                    }
+                }
+                publish<T>(pos, skip, std::forward<Args>(args)...);
+            }
+            template<typename T, typename ...Args>
+            [[nodiscard]] bool try_emplace(Args &&... args) noexcept
+            requires (message_type_count<T,Ts...> == 1) && std::is_nothrow_constructible_v<T,Args &&...>{
+                constexpr size_t slots = message_slots<T>;
+                size_t pos = tail_.load(std::memory_order_relaxed);
+                while(true){
+                    const size_t skip = skip_for(pos, slots);
+                    int64_t diff = 0;
+                    if(is_free(pos, skip + slots, diff)){
+                        if(tail_.compare_exchange_weak(pos, pos + skip + slots, std::memory_order_relaxed, std::memory_order_relaxed)){
+                            publish<T>(pos, skip, std::forward<Args>(args)...);
+                            return true;
+                        }
+                        continue;
+                    }else if(diff < 0){
+                        return false;
+                    }
+                    pos = tail_.load(std::memory_order_relaxed);
+                }
+            }
+            template<typename T>
+            void push(T &&message) noexcept
+            requires (message_type_count<std::remove_cvref_t<T>,Ts...> == 1){
+                emplace<std::remove_cvref_t<T>>(std::forward<T>(message));
+            }
+            template<typename T>
+            [[nodiscard]] bool try_push(T &&message) noexcept
+            requires (message_type_count<std::remove_cvref_t<T>,Ts...> == 1){
+                return try_emplace<std::remove_cvref_t<T>>(std::forward<T>(message));
+            }
+            // Calls handler(T&) for the next message if one is published, handlers must not throw
+            template<typename F>
+            [[nodiscard]] bool try_pop(F &&handler) noexcept
+            requires (std::is_invocable_v<F&,Ts&> && ...){
+                size_t pos = head_.load(std::memory_order_relaxed);
+                while(true){
+                    State &first = state(pos);
+                    const int64_t diff = int64_t(first.seq_.load(std::memory_order_acquire) - (pos + 1));
+                    if(diff == 0){
+                        const uint32_t info = first.info_.load(std::memory_order_relaxed);
+                        const size_t slots = info >> 16;
+                        if(head_.compare_exchange_weak(pos, pos + slots, std::memory_order_relaxed, std::memory_order_relaxed)){
+                            const uint32_t type = info & 0xffff;
+                            const size_t skip = slots - slots_of(type);
+                            jump_table<std::remove_reference_t<F>>[type](line(pos + skip), handler);
+                            release(pos, slots);
+                            return true;
+                        }
+                        continue;
+                    }else if(diff < 0){
+                        return false;
+                    }
+                    pos = head_.load(std::memory_order_relaxed);
+                }
+            }
+            template<typename F>
+            void pop(F &&handler) noexcept
+            requires (std::is_invocable_v<F&,Ts&> && ...){
+                while(!try_pop(handler)){
+                    cpu_relax();
+                }
+            }
+            // Approximate number of occupied slots, exact only when no push or pop is in flight
+            size_t size() const noexcept{
+                const size_t head = head_.load(std::memory_order_relaxed);
+                const size_t tail = tail_.load(std::memory_order_relaxed);
+                const int64_t diff = tail - head;
+                return diff < 0 ? 0 : (size_t(diff) > buffer_size_ ? buffer_size_ : size_t(diff));
+            }
+            size_t capacity() const noexcept{
+                return buffer_size_;
+            }
+    };
+}
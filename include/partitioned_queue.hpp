@@ -0,0 +1,180 @@
+#pragma once
+// Key-affinity dispatcher: elements with the same key always land on the same consumer lane
+// Keys hash onto a fixed number of partitions, partitions map onto lanes and the map can be rebalanced
+
+#include "atomic_queue.hpp"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+namespace sl{
+    template<typename KeyFn, typename T>
+    concept IsKeyFunction = std::invocable<const KeyFn&, const T&>
+                            && requires(std::invoke_result_t<const KeyFn&, const T&> key){
+                                { std::hash<std::remove_cvref_t<decltype(key)>>{}(key) } -> std::convertible_to<size_t>;
+                            };
+    struct LaneStats{
+        size_t lane_;
+        size_t partitions_; // partitions currently mapped to the lane
+        uint64_t pushed_;   // elements enqueued on the lane since the last rebalance
+        uint64_t popped_;
+        size_t depth_;      // approximate elements waiting
+    };
+    // Each lane is an MPMCQueue drained by exactly one consumer, producers may be many
+    // Ordering is FIFO per key in the order producers claimed their slots
+    template<
+        typename T,
+        typename KeyFn,
+        size_t N,
+        size_t Partitions = 256
+    >
+    requires IsValidMPMCQueue<T,N,EnablePowerOfTwo> && IsKeyFunction<KeyFn,T> && (Partitions > 0) && (is_power_of_two(Partitions))
+    class PartitionedQueue{
+        private:
+            using lane_type = MPMCQueue<T,N>;
+            using key_type = std::remove_cvref_t<std::invoke_result_t<const KeyFn&, const T&>>;
+            struct alignas(cache_line) PartitionLoad{
+                std::atomic<uint64_t> pushed_{0};
+            };
+            struct alignas(cache_line) LaneCounters{
+                std::atomic<uint64_t> popped_{0}; // written by the lane's consumer only
+            };
+            const KeyFn key_fn_;
+            std::vector<std::unique_ptr<lane_type>> lanes_;
+            std::unique_ptr<LaneCounters[]> lane_counters_;
+            // Partition to lane map, only rewritten at a quiescent point
+            std::array<std::atomic<uint32_t>, Partitions> lane_of_partition_;
+            std::unique_ptr<PartitionLoad[]> partition_load_;
+
+            static constexpr size_t partition_of_hash(size_t hash) noexcept{
+                if constexpr(Partitions == 1){
+                    return 0;
+                }else{
+                    // Fibonacci hashing spreads weak std::hash values such as identity hashes of integers
+                    return static_cast<size_t>((uint64_t(hash) * 0x9E3779B97F4A7C15ull) >> (64 - std::bit_width(Partitions - 1)));
+                }
+            }
+        public:
+            explicit PartitionedQueue(const size_t lanes, const KeyFn &key_fn = KeyFn(), const size_t lane_size = N):
+            key_fn_(key_fn),
+            lane_counters_(new LaneCounters[std::clamp(lanes, size_t(1), Partitions)]),
+            partition_load_(new PartitionLoad[Partitions]){
+                // Every lane needs at least one partition
+                const size_t lane_count = std::clamp(lanes, size_t(1), Partitions);
+                lanes_.reserve(lane_count);
+                for(size_t i = 0; i < lane_count; ++i){
+                    lanes_.push_back(std::make_unique<lane_type>(lane_size));
+                }
+                // Round robin start, rebalance() later follows the observed load
+                for(size_t p = 0; p < Partitions; ++p){
+                    lane_of_partition_[p].store(static_cast<uint32_t>(p % lane_count), std::memory_order_relaxed);
+                }
+            }
+            PartitionedQueue(const PartitionedQueue&) = delete;
+            PartitionedQueue& operator=(const PartitionedQueue&) = delete;
+            PartitionedQueue(PartitionedQueue&& other) = delete;
+            PartitionedQueue& operator=(PartitionedQueue&& other) = delete;
+
+            size_t lanes() const noexcept{
+                return lanes_.size();
+            }
+            size_t partition_of(const T& value) const noexcept{
+                return partition_of_hash(std::hash<key_type>{}(std::invoke(key_fn_, value)));
+            }
+            size_t lane_of(const T& value) const noexcept{
+                return lane_of_partition_[partition_of(value)].load(std::memory_order_relaxed);
+            }
+            template<typename P>
+            void push(P &&value) noexcept(std::is_nothrow_constructible_v<T,P>)
+            requires std::is_constructible_v<T,P>{
+                const size_t partition = partition_of(value);
+                const size_t lane = lane_of_partition_[partition].load(std::memory_order_relaxed);
+                lanes_[lane]->push(std::forward<P>(value));
+                // Counted once queued, like try_push, so a push blocked on a full lane does not skew rebalance()
+                partition_load_[partition].pushed_.fetch_add(1, std::memory_order_relaxed);
+            }
+            template<typename P>
+            [[nodiscard]] bool try_push(P &&value) noexcept(std::is_nothrow_constructible_v<T,P>)
+            requires std::is_constructible_v<T,P>{
+                const size_t partition = partition_of(value);
+                const size_t lane = lane_of_partition_[partition].load(std::memory_order_relaxed);
+                if(!lanes_[lane]->try_push(std::forward<P>(value))){
+                    return false;
+                }
+                partition_load_[partition].pushed_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            // Only the consumer that owns the lane may pop from it
+            void pop(const size_t lane, T &value) noexcept{
+                lanes_[lane]->pop(value);
+                auto &popped = lane_counters_[lane].popped_;
+                popped.store(popped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+            [[nodiscard]] bool try_pop(const size_t lane, T &value) noexcept{
+                if(!lanes_[lane]->try_pop(value)){
+                    return false;
+                }
+                auto &popped = lane_counters_[lane].popped_;
+                popped.store(popped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return true;
+            }
+            std::vector<LaneStats> lane_stats() const{
+                std::vector<LaneStats> result(lanes_.size());
+                for(size_t i = 0; i < lanes_.size(); ++i){
+                    result[i] = LaneStats{i, 0, 0, lane_counters_[i].popped_.load(std::memory_order_relaxed), lanes_[i]->size()};
+                }
+                for(size_t p = 0; p < Partitions; ++p){
+                    auto &stats = result[lane_of_partition_[p].load(std::memory_order_relaxed)];
+                    ++stats.partitions_;
+                    stats.pushed_ += partition_load_[p].pushed_.load(std::memory_order_relaxed);
+                }
+                return result;
+            }
+            // Busiest lane over the mean lane load, 1.0 is perfectly even and lanes() is one hot key
+            double skew() const{
+                const auto stats = lane_stats();
+                uint64_t total = 0, busiest = 0;
+                for(const auto &lane : stats){
+                    total += lane.pushed_;
+                    busiest = std::max(busiest, lane.pushed_);
+                }
+                return total ? double(busiest) * double(stats.size()) / double(total) : 1.0;
+            }
+            // Reassign partitions to lanes from the load seen since the last rebalance, heaviest first onto the lightest lane
+            // Must run at a quiescent point: producers are paused and synchronised with the caller, returns false if any lane still holds data
+            bool rebalance(){
+                for(const auto &lane : lanes_){
+                    if(lane->size() != 0){
+                        return false;
+                    }
+                }
+                std::array<uint64_t, Partitions> load;
+                for(size_t p = 0; p < Partitions; ++p){
+                    load[p] = partition_load_[p].pushed_.load(std::memory_order_relaxed);
+                }
+                std::array<uint32_t, Partitions> order;
+                std::iota(order.begin(), order.end(), 0);
+                std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){ return load[a] > load[b]; });
+                std::vector<uint64_t> lane_load(lanes_.size(), 0);
+                std::vector<size_t> lane_partitions(lanes_.size(), 0);
+                for(const uint32_t p : order){
+                    // Ties go to the lane with fewer partitions so idle partitions still spread out
+                    size_t target = 0;
+                    for(size_t l = 1; l < lanes_.size(); ++l){
+                        if(lane_load[l] < lane_load[target] ||
+                           (lane_load[l] == lane_load[target] && lane_partitions[l] < lane_partitions[target])){
+                            target = l;
+                        }
+                    }
+                    lane_load[target] += load[p];
+                    ++lane_partitions[target];
+                    lane_of_partition_[p].store(static_cast<uint32_t>(target), std::memory_order_relaxed);
+                }
+                for(size_t p = 0; p < Partitions; ++p){
+                    partition_load_[p].pushed_.store(0, std::memory_order_relaxed);
+                }
+                return true;
+            }
+    };
+}
@@ -0,0 +1,363 @@
+#pragma once
+// Multi-stage pipeline built on the queues of atomic_queue.hpp
+// Each stage runs on its own threads, links between stages are chosen from the stage parallelism
+
+#include "atomic_queue.hpp"
+#include "topology.hpp"
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sl{
+    // Shape of a link, decided by the parallelism of the stages on both sides
+    enum class LinkKind{ SPSC, MPSC, SPMC, MPMC };
+    static constexpr const char* to_string(LinkKind kind) noexcept{
+        switch(kind){
+            case LinkKind::SPSC: return "SPSC";
+            case LinkKind::MPSC: return "MPSC";
+            case LinkKind::SPMC: return "SPMC";
+            default: return "MPMC";
+        }
+    }
+    struct StageOptions{
+        size_t parallelism_ = 1;
+        size_t batch_size_ = 32;  // elements drained from the input before processing
+        std::vector<int> cpus_{}; // thread i is pinned to cpus_[i % cpus_.size()], empty means unpinned, see CpuTopology plans
+    };
+    // Snapshot of one stage, the stage with a full input and an empty output is the bottleneck
+    struct StageStats{
+        std::string name_;
+        size_t parallelism_;
+        LinkKind input_kind_;
+        size_t input_depth_;    // approximate elements waiting in the input link
+        size_t input_capacity_;
+        uint64_t processed_;
+        uint64_t batches_;
+        uint64_t idle_polls_;   // polls that found the input empty
+        double occupancy() const noexcept{
+            return input_capacity_ ? double(input_depth_) / double(input_capacity_) : 0.0;
+        }
+        double mean_batch() const noexcept{
+            return batches_ ? double(processed_) / double(batches_) : 0.0;
+        }
+    };
+    class PipelineLinkBase{
+        public:
+            virtual ~PipelineLinkBase() = default;
+            virtual LinkKind kind() const noexcept = 0;
+            virtual size_t size() const noexcept = 0;
+            virtual size_t capacity() const noexcept = 0;
+    };
+    // One hop between stages, carries the end-of-stream state next to the queue
+    template<typename T, size_t Capacity>
+    class PipelineLink : public PipelineLinkBase{
+        private:
+            // Only a single consumer may use SPSCQueue, every other shape shares MPMCQueue
+            using spsc_queue = SPSCQueue<T,Capacity>;
+            using mpmc_queue = MPMCQueue<T,Capacity>;
+            const LinkKind kind_;
+            std::unique_ptr<spsc_queue> spsc_;
+            std::unique_ptr<mpmc_queue> mpmc_;
+            alignas(cache_line) std::atomic<size_t> producers_; // upstream threads still running
+        public:
+            PipelineLink(size_t producers, size_t consumers):
+            kind_(producers == 1 ? (consumers == 1 ? LinkKind::SPSC : LinkKind::SPMC)
+                                 : (consumers == 1 ? LinkKind::MPSC : LinkKind::MPMC)),
+            producers_(producers){
+                if(kind_ == LinkKind::SPSC){
+                    spsc_ = std::make_unique<spsc_queue>();
+                }else{
+                    mpmc_ = std::make_unique<mpmc_queue>();
+                }
+            }
+            template<typename P>
+            [[nodiscard]] bool try_push(P &&value) noexcept(std::is_nothrow_constructible_v<T,P>){
+                return kind_ == LinkKind::SPSC ? spsc_->try_push(std::forward<P>(value))
+                                               : mpmc_->try_push(std::forward<P>(value));
+            }
+            [[nodiscard]] bool try_pop(T &value) noexcept{
+                return kind_ == LinkKind::SPSC ? spsc_->try_pop(value) : mpmc_->try_pop(value);
+            }
+            // Called once by every upstream thread after its last push
+            void producer_done() noexcept{
+                producers_.fetch_sub(1, std::memory_order_release);
+            }
+            // End of stream from outside the pipeline, regardless of how many threads were pushing
+            void close() noexcept{
+                producers_.store(0, std::memory_order_release);
+            }
+            // Every push that happened before the last producer_done is visible once this is true
+            bool closed() const noexcept{
+                return producers_.load(std::memory_order_acquire) == 0;
+            }
+            LinkKind kind() const noexcept override{ return kind_; }
+            size_t size() const noexcept override{
+                return kind_ == LinkKind::SPSC ? spsc_->size() : mpmc_->size();
+            }
+            size_t capacity() const noexcept override{
+                return kind_ == LinkKind::SPSC ? spsc_->capacity() : mpmc_->capacity();
+            }
+    };
+    class PipelineStageBase{
+        public:
+            virtual ~PipelineStageBase() = default;
+            virtual void start(const std::atomic<bool> &stop) = 0;
+            virtual void join() = 0;
+            virtual StageStats stats() const = 0;
+    };
+    // Stage threads drain a batch from the input, run the callable on each element and forward the results
+    // Out is void for the sink stage
+    template<typename In, typename Out, typename F, size_t Capacity>
+    class PipelineStage : public PipelineStageBase{
+        private:
+            static constexpr bool IsSink = std::is_void_v<Out>;
+            using output_link = PipelineLink<Out,Capacity>;
+            struct alignas(cache_line) Counters{
+                std::atomic<uint64_t> processed_{0};
+                std::atomic<uint64_t> batches_{0};
+                std::atomic<uint64_t> idle_polls_{0};
+            };
+            const std::string name_;
+            const StageOptions options_;
+            F fn_;
+            PipelineLink<In,Capacity> *input_;
+            output_link *output_ = nullptr;
+            std::vector<std::thread> threads_;
+            std::unique_ptr<Counters[]> counters_;
+
+            void run(size_t index, const std::atomic<bool> &stop){
+                if(!options_.cpus_.empty()){
+                    pin_current_thread(options_.cpus_[index % options_.cpus_.size()]);
+                }
+                // Each thread owns a copy of the callable so stateful stages need no locking
+                F fn = fn_;
+                Counters &counters = counters_[index];
+                std::vector<In> batch(options_.batch_size_);
+                size_t idle = 0;
+                while(!stop.load(std::memory_order_relaxed)){
+                    size_t count = 0;
+                    while(count < batch.size() && input_->try_pop(batch[count])){
+                        ++count;
+                    }
+                    if(count == 0){
+                        if(!input_->closed()){
+                            counters.idle_polls_.fetch_add(1, std::memory_order_relaxed);
+                            if(++idle < 64){
+                                cpu_relax();
+                            }else{
+                                std::this_thread::yield();
+                            }
+                            continue;
+                        }
+                        // Upstream is done, one more drain sees everything it pushed
+                        while(count < batch.size() && input_->try_pop(batch[count])){
+                            ++count;
+                        }
+                        if(count == 0){
+                            break;
+                        }
+                    }
+                    idle = 0;
+                    for(size_t i = 0; i < count; ++i){
+                        if constexpr(IsSink){
+                            fn(std::move(batch[i]));
+                        }else{
+                            Out out = fn(std::move(batch[i]));
+                            while(!output_->try_push(std::move(out))){
+                                if(stop.load(std::memory_order_relaxed)){
+                                    return;
+                                }
+                                cpu_relax();
+                            }
+                        }
+                    }
+                    counters.processed_.fetch_add(count, std::memory_order_relaxed);
+                    counters.batches_.fetch_add(1, std::memory_order_relaxed);
+                }
+                if constexpr(!IsSink){
+                    output_->producer_done();
+                }
+            }
+        public:
+            PipelineStage(std::string name, StageOptions options, F fn, PipelineLink<In,Capacity> *input):
+            name_(std::move(name)),
+            options_(std::move(options)),
+            fn_(std::move(fn)),
+            input_(input),
+            counters_(new Counters[options_.parallelism_]){}
+            void connect(output_link *output) noexcept{
+                output_ = output;
+            }
+            void start(const std::atomic<bool> &stop) override{
+                for(size_t i = 0; i < options_.parallelism_; ++i){
+                    threads_.emplace_back([this, i, &stop]{ run(i, stop); });
+                }
+            }
+            void join() override{
+                for(auto &thread : threads_){
+                    if(thread.joinable()){
+                        thread.join();
+                    }
+                }
+            }
+            StageStats stats() const override{
+                StageStats result{name_, options_.parallelism_, input_->kind(), input_->size(), input_->capacity(), 0, 0, 0};
+                for(size_t i = 0; i < options_.parallelism_; ++i){
+                    result.processed_ += counters_[i].processed_.load(std::memory_order_relaxed);
+                    result.batches_ += counters_[i].batches_.load(std::memory_order_relaxed);
+                    result.idle_polls_ += counters_[i].idle_polls_.load(std::memory_order_relaxed);
+                }
+                return result;
+            }
+    };
+    // Links and stages of a pipeline, shared by the builder steps and the running pipeline
+    template<typename In, size_t Capacity>
+    struct PipelineGraph{
+        PipelineLink<In,Capacity> *source_ = nullptr;
+        std::vector<std::unique_ptr<PipelineLinkBase>> links_;
+        std::vector<std::unique_ptr<PipelineStageBase>> stages_;
+        std::atomic<bool> stop_{false};
+    };
+    template<typename In, size_t Capacity = 1024>
+    class Pipeline;
+    // Declares the stages in order, Current is the element type leaving the last declared stage
+    template<typename In, typename Current = In, size_t Capacity = 1024>
+    requires std::default_initializable<In> && ValidSizeParameter<Capacity,EnablePowerOfTwo>
+    class PipelineBuilder{
+        private:
+            template<typename I, typename C, size_t Cap>
+            requires std::default_initializable<I> && ValidSizeParameter<Cap,EnablePowerOfTwo>
+            friend class PipelineBuilder;
+            using graph_type = PipelineGraph<In,Capacity>;
+            std::unique_ptr<graph_type> graph_;
+            size_t upstream_parallelism_;
+            // Hands the next stage's input link to whoever produces Current
+            std::function<void(PipelineLink<Current,Capacity>*)> connect_;
+
+            PipelineBuilder(std::unique_ptr<graph_type> graph, size_t upstream_parallelism,
+                            std::function<void(PipelineLink<Current,Capacity>*)> connect):
+            graph_(std::move(graph)),
+            upstream_parallelism_(upstream_parallelism),
+            connect_(std::move(connect)){}
+
+            template<typename Out, typename F>
+            PipelineBuilder<In,Out,Capacity> add(std::string name, StageOptions options, F fn){
+                options.parallelism_ = options.parallelism_ == 0 ? 1 : options.parallelism_;
+                options.batch_size_ = options.batch_size_ == 0 ? 1 : options.batch_size_;
+                auto link = std::make_unique<PipelineLink<Current,Capacity>>(upstream_parallelism_, options.parallelism_);
+                connect_(link.get());
+                using stage_type = PipelineStage<Current,Out,F,Capacity>;
+                const size_t parallelism = options.parallelism_;
+                auto stage = std::make_unique<stage_type>(std::move(name), std::move(options), std::move(fn), link.get());
+                stage_type *raw = stage.get();
+                graph_->links_.push_back(std::move(link));
+                graph_->stages_.push_back(std::move(stage));
+                std::function<void(PipelineLink<Out,Capacity>*)> connect;
+                if constexpr(!std::is_void_v<Out>){
+                    connect = [raw](PipelineLink<Out,Capacity> *output){ raw->connect(output); };
+                }
+                return PipelineBuilder<In,Out,Capacity>(std::move(graph_), parallelism, std::move(connect));
+            }
+        public:
+            // source_producers is the number of outside threads that will push, it only picks the first link type
+            explicit PipelineBuilder(size_t source_producers = 1)
+            requires std::is_same_v<In,Current>:
+            graph_(std::make_unique<graph_type>()),
+            upstream_parallelism_(source_producers == 0 ? 1 : source_producers){
+                graph_type *graph = graph_.get();
+                connect_ = [graph](PipelineLink<In,Capacity> *link){ graph->source_ = link; };
+            }
+            // Intermediate stage, fn turns a Current into the next stage's input
+            template<typename F>
+            requires std::invocable<F&,Current&&> && (!std::is_void_v<std::invoke_result_t<F&,Current&&>>)
+                     && std::default_initializable<std::invoke_result_t<F&,Current&&>>
+                     && std::copy_constructible<F>
+            auto stage(std::string name, StageOptions options, F fn){
+                return add<std::invoke_result_t<F&,Current&&>>(std::move(name), std::move(options), std::move(fn));
+            }
+            // Final stage, consumes Current without producing anything
+            template<typename F>
+            requires std::invocable<F&,Current&&> && std::copy_constructible<F>
+            auto sink(std::string name, StageOptions options, F fn){
+                return add<void>(std::move(name), std::move(options), std::move(fn));
+            }
+            Pipeline<In,Capacity> build()
+            requires std::is_void_v<Current>{
+                return Pipeline<In,Capacity>(std::move(graph_));
+            }
+    };
+    // Running pipeline, outside threads push into the first stage and close() ends the stream
+    template<typename In, size_t Capacity>
+    class Pipeline{
+        private:
+            template<typename I, typename C, size_t Cap>
+            requires std::default_initializable<I> && ValidSizeParameter<Cap,EnablePowerOfTwo>
+            friend class PipelineBuilder;
+            std::unique_ptr<PipelineGraph<In,Capacity>> graph_;
+            bool started_ = false;
+
+            explicit Pipeline(std::unique_ptr<PipelineGraph<In,Capacity>> graph) noexcept:
+            graph_(std::move(graph)){}
+        public:
+            Pipeline(Pipeline&&) noexcept = default;
+            Pipeline& operator=(Pipeline&&) = delete;
+            Pipeline(const Pipeline&) = delete;
+            Pipeline& operator=(const Pipeline&) = delete;
+            // Abandons in-flight elements if the caller never closed the stream
+            ~Pipeline(){
+                if(graph_){
+                    stop();
+                    join();
+                }
+            }
+            void start(){
+                if(started_){
+                    return;
+                }
+                started_ = true;
+                for(auto &stage : graph_->stages_){
+                    stage->start(graph_->stop_);
+                }
+            }
+            template<typename P>
+            [[nodiscard]] bool try_push(P &&value) noexcept(std::is_nothrow_constructible_v<In,P>)
+            requires std::is_constructible_v<In,P>{
+                return graph_->source_->try_push(std::forward<P>(value));
+            }
+            // Spins while the first stage is full, returns false once the pipeline is stopped
+            template<typename P>
+            bool push(P &&value) noexcept(std::is_nothrow_constructible_v<In,P>)
+            requires std::is_constructible_v<In,P>{
+                while(!graph_->source_->try_push(std::forward<P>(value))){
+                    if(graph_->stop_.load(std::memory_order_relaxed)){
+                        return false;
+                    }
+                    cpu_relax();
+                }
+                return true;
+            }
+            // End of stream, every stage drains its input and exits after its upstream has exited
+            void close() noexcept{
+                graph_->source_->close();
+            }
+            // Shutdown, stages exit at the next batch boundary and drop what is still queued
+            void stop() noexcept{
+                graph_->stop_.store(true, std::memory_order_relaxed);
+            }
+            void join(){
+                for(auto &stage : graph_->stages_){
+                    stage->join();
+                }
+            }
+            std::vector<StageStats> stats() const{
+                std::vector<StageStats> result;
+                result.reserve(graph_->stages_.size());
+                for(const auto &stage : graph_->stages_){
+                    result.push_back(stage->stats());
+                }
+                return result;
+            }
+    };
+}
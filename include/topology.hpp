@@ -0,0 +1,266 @@
+#pragma once
+// CPU topology discovery and thread placement for producer/consumer threads
+// Reads /sys/devices/system/cpu on Linux, elsewhere detection returns an empty topology and pinning fails
+
+#include "atomic_queue.hpp"
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace sl{
+    struct CpuInfo{
+        int cpu_;
+        int core_;      // lowest cpu among the SMT siblings
+        int package_;
+        int node_;
+        int l2_;        // lowest cpu sharing this cpu's L2, identifies the L2 domain
+        int l3_;        // lowest cpu sharing this cpu's L3, identifies the L3 domain
+        std::vector<int> smt_siblings_; // including the cpu itself
+    };
+    // Domains a producer/consumer pair may be asked to share
+    enum class ShareLevel{ L2, L3, Node, Any };
+    struct ThreadPair{
+        int producer_cpu_;
+        int consumer_cpu_;
+    };
+    static inline bool parse_int(std::string_view text, int &value) noexcept{
+        while(!text.empty() && (text.back() == '\n' || text.back() == ' ')){
+            text.remove_suffix(1);
+        }
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() && end == text.data() + text.size() && !text.empty();
+    }
+    // Parse a sysfs cpu list such as "0-3,8,10-11", malformed input yields an empty list
+    static inline std::vector<int> parse_cpu_list(std::string_view text){
+        std::vector<int> cpus;
+        while(!text.empty() && (text.back() == '\n' || text.back() == ' ')){
+            text.remove_suffix(1);
+        }
+        size_t pos = 0;
+        while(pos < text.size()){
+            size_t end = text.find(',', pos);
+            end = end == std::string_view::npos ? text.size() : end;
+            const std::string_view item = text.substr(pos, end - pos);
+            const size_t dash = item.find('-');
+            int first, last;
+            if(dash == std::string_view::npos){
+                if(!parse_int(item, first)){
+                    return {};
+                }
+                last = first;
+            }else if(!parse_int(item.substr(0, dash), first) || !parse_int(item.substr(dash + 1), last)){
+                return {};
+            }
+            for(int cpu = first; cpu <= last; ++cpu){
+                cpus.push_back(cpu);
+            }
+            pos = end + 1;
+        }
+        return cpus;
+    }
+    class CpuTopology{
+        private:
+            std::vector<CpuInfo> cpus_;
+
+            static std::string read_line(const std::filesystem::path &path){
+                std::ifstream file(path);
+                std::string line;
+                std::getline(file, line);
+                return line;
+            }
+            static int read_int(const std::filesystem::path &path, int fallback){
+                int value;
+                return parse_int(read_line(path), value) ? value : fallback;
+            }
+            static int lowest(const std::vector<int> &cpus, int fallback){
+                return cpus.empty() ? fallback : *std::min_element(cpus.begin(), cpus.end());
+            }
+            // Cpus of the same domain, ordered by cpu number
+            std::map<int, std::vector<int>> domains(ShareLevel level, bool avoid_smt) const{
+                std::map<int, std::vector<int>> result;
+                for(const CpuInfo &info : cpus_){
+                    if(avoid_smt && info.core_ != info.cpu_){
+                        continue;
+                    }
+                    int key = 0;
+                    switch(level){
+                        case ShareLevel::L2: key = info.l2_; break;
+                        case ShareLevel::L3: key = info.l3_; break;
+                        case ShareLevel::Node: key = info.node_; break;
+                        case ShareLevel::Any: key = 0; break;
+                    }
+                    result[key].push_back(info.cpu_);
+                }
+                return result;
+            }
+        public:
+            // root is only overridden by tests that fake a sysfs tree
+            static CpuTopology detect(const std::filesystem::path &root = "/sys/devices/system/cpu"){
+                CpuTopology topology;
+                std::error_code error;
+                if(!std::filesystem::exists(root / "online", error)){
+                    return topology;
+                }
+                for(const int cpu : parse_cpu_list(read_line(root / "online"))){
+                    const std::filesystem::path dir = root / ("cpu" + std::to_string(cpu));
+                    CpuInfo info{cpu, cpu, 0, 0, cpu, cpu, {}};
+                    info.smt_siblings_ = parse_cpu_list(read_line(dir / "topology" / "thread_siblings_list"));
+                    if(info.smt_siblings_.empty()){
+                        info.smt_siblings_.push_back(cpu);
+                    }
+                    info.core_ = lowest(info.smt_siblings_, cpu);
+                    info.package_ = read_int(dir / "topology" / "physical_package_id", 0);
+                    info.l2_ = info.core_;
+                    info.l3_ = -1;
+                    for(const auto &entry : std::filesystem::directory_iterator(dir, error)){
+                        const std::string name = entry.path().filename().string();
+                        int node;
+                        if(name.rfind("node", 0) == 0 && parse_int(std::string_view(name).substr(4), node)){
+                            info.node_ = node;
+                        }
+                    }
+                    for(const auto &entry : std::filesystem::directory_iterator(dir / "cache", error)){
+                        if(entry.path().filename().string().rfind("index", 0) != 0){
+                            continue;
+                        }
+                        if(read_line(entry.path() / "type") == "Instruction"){
+                            continue;
+                        }
+                        const int level = read_int(entry.path() / "level", 0);
+                        const int domain = lowest(parse_cpu_list(read_line(entry.path() / "shared_cpu_list")), cpu);
+                        if(level == 2){
+                            info.l2_ = domain;
+                        }else if(level == 3){
+                            info.l3_ = domain;
+                        }
+                    }
+                    // Without an L3 the package is the widest shared cache domain
+                    if(info.l3_ < 0){
+                        info.l3_ = -1 - info.package_;
+                    }
+                    topology.cpus_.push_back(std::move(info));
+                }
+                return topology;
+            }
+            const std::vector<CpuInfo> &cpus() const noexcept{
+                return cpus_;
+            }
+            bool empty() const noexcept{
+                return cpus_.empty();
+            }
+            const CpuInfo *find(int cpu) const noexcept{
+                for(const CpuInfo &info : cpus_){
+                    if(info.cpu_ == cpu){
+                        return &info;
+                    }
+                }
+                return nullptr;
+            }
+            int node_of(int cpu) const noexcept{
+                const CpuInfo *info = find(cpu);
+                return info ? info->node_ : 0;
+            }
+            std::vector<int> cpus_of_node(int node) const{
+                std::vector<int> result;
+                for(const CpuInfo &info : cpus_){
+                    if(info.node_ == node){
+                        result.push_back(info.cpu_);
+                    }
+                }
+                return result;
+            }
+            // Up to `pairs` producer/consumer pairs whose two cpus share `level`, no cpu is used twice
+            // With avoid_smt every cpu of the plan sits on a different physical core, which rules out L2 pairs on most x86 parts
+            // Returns fewer pairs when the machine cannot satisfy the request
+            std::vector<ThreadPair> plan_pairs(size_t pairs, ShareLevel level, bool avoid_smt) const{
+                std::vector<ThreadPair> result;
+                auto groups = domains(level, avoid_smt);
+                // Fill one domain before moving on, so pairs beyond the first stay clustered too
+                for(auto &[domain, cpus] : groups){
+                    for(size_t i = 0; i + 1 < cpus.size() && result.size() < pairs; i += 2){
+                        result.push_back(ThreadPair{cpus[i], cpus[i + 1]});
+                    }
+                }
+                return result;
+            }
+            // Up to `threads` cpus, one per physical core when avoid_smt, spread round robin across L3 domains
+            std::vector<int> plan_spread(size_t threads, bool avoid_smt) const{
+                std::vector<int> result;
+                auto groups = domains(ShareLevel::L3, avoid_smt);
+                for(size_t round = 0; result.size() < threads; ++round){
+                    bool any = false;
+                    for(auto &[domain, cpus] : groups){
+                        if(round < cpus.size() && result.size() < threads){
+                            result.push_back(cpus[round]);
+                            any = true;
+                        }
+                    }
+                    if(!any){
+                        break;
+                    }
+                }
+                return result;
+            }
+    };
+    // Pin the calling thread to one cpu, returns false when unsupported or rejected
+    static inline bool pin_current_thread(int cpu) noexcept{
+        #if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+        #else
+        (void)cpu;
+        return false;
+        #endif
+    }
+    static inline bool pin_thread(std::thread &thread, int cpu) noexcept{
+        #if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+        #else
+        (void)thread;
+        (void)cpu;
+        return false;
+        #endif
+    }
+    // Construct a queue from a thread pinned to `cpu`
+    // First-touch places the buffer pages on that cpu's NUMA node: the constructor touches every cell,
+    // and zero-page queues, whose constructor touches nothing, are prefaulted from the same thread
+    // Pass the consumer's cpu to keep the ring local to the side that polls it hardest
+    template<typename Queue, typename ...Args>
+    std::unique_ptr<Queue> make_queue_near(int cpu, Args &&... args){
+        std::unique_ptr<Queue> queue;
+        std::thread builder([&]{
+            pin_current_thread(cpu);
+            queue = std::make_unique<Queue>(std::forward<Args>(args)...);
+            if constexpr(requires(Queue &q){ q.prefault(size_t(1)); }){
+                // One thread, helpers would inherit the single cpu affinity anyway
+                queue->prefault(1);
+            }
+        });
+        builder.join();
+        return queue;
+    }
+    // Same as make_queue_near with the first cpu of a NUMA node, falls back to an unpinned build
+    template<typename Queue, typename ...Args>
+    std::unique_ptr<Queue> make_queue_on_node(const CpuTopology &topology, int node, Args &&... args){
+        const std::vector<int> cpus = topology.cpus_of_node(node);
+        if(cpus.empty()){
+            return std::make_unique<Queue>(std::forward<Args>(args)...);
+        }
+        return make_queue_near<Queue>(cpus.front(), std::forward<Args>(args)...);
+    }
+}
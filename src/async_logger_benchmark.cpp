@@ -0,0 +1,89 @@
+#include "../include/async_logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Benchmark of the caller-side cost of one log call, sl::AsyncLogger against a synchronous
+// spdlog-style logger that formats and writes under a mutex on the calling thread
+static int ITEMS_PER_THREAD = 200000;
+static const char* PATH = "/dev/null";
+
+class SyncLogger {
+public:
+    explicit SyncLogger(const char* path) : file_(std::fopen(path, "a")) {}
+    ~SyncLogger() { if (file_) std::fclose(file_); }
+    template<typename ...Args>
+    void info(const char* format, const Args&... args) {
+        char line[512];
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        const long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+        int n = std::snprintf(line, sizeof(line), "%lld.%09lld INFO  ", ns / 1000000000, ns % 1000000000);
+        n += std::snprintf(line + n, sizeof(line) - n, format, args...);
+        line[n++] = '\n';
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::fwrite(line, 1, n, file_);
+    }
+private:
+    std::mutex mutex_;
+    FILE* file_;
+};
+
+template<typename Log>
+static void run(const char* name, int threads, Log log) {
+    std::vector<std::vector<uint64_t>> samples(threads);
+    std::vector<std::thread> workers;
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            samples[t].reserve(ITEMS_PER_THREAD / 64 + 1);
+            for (int i = 0; i < ITEMS_PER_THREAD; ++i) {
+                const uint64_t begin = sl::rdtsc();
+                log(t, i);
+                // Sample every 64th call to keep the measurement off the hot path
+                if ((i & 63) == 0) samples[t].push_back(sl::rdtsc() - begin);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    std::vector<uint64_t> all;
+    for (auto& s : samples) all.insert(all.end(), s.begin(), s.end());
+    std::sort(all.begin(), all.end());
+    static const double ticks_per_ns = sl::calibrate_tsc();
+    std::cout << name << " " << threads << "T: "
+              << double(elapsed.count()) / (double(threads) * ITEMS_PER_THREAD) << "ns/call wall, "
+              << "p50 " << double(all[all.size() / 2]) / ticks_per_ns << "ns, "
+              << "p99 " << double(all[all.size() * 99 / 100]) / ticks_per_ns << "ns" << std::endl;
+}
+
+// Usage: async_logger_benchmark [items_per_thread] [log_path]
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        ITEMS_PER_THREAD = std::atoi(argv[1]);
+    }
+    if (argc > 2) {
+        PATH = argv[2];
+    }
+    for (int threads : {1, 2, 4, 8, 16}) {
+        {
+            SyncLogger logger(PATH);
+            run("sync mutex  ", threads, [&](int t, int i) { logger.info("thread %d message %d value %f", t, i, i * 0.5); });
+        }
+        {
+            sl::AsyncLogger<sl::BlockWhenFull> logger(PATH);
+            run("AsyncLogger ", threads, [&](int t, int i) { logger.info("thread %d message %d value %f", t, i, i * 0.5); });
+            logger.flush();
+        }
+        {
+            sl::AsyncLogger<sl::CountWhenFull> logger(PATH);
+            run("Async count ", threads, [&](int t, int i) { logger.info("thread %d message %d value %f", t, i, i * 0.5); });
+            logger.flush();
+            std::cout << "Async count dropped: " << logger.dropped() << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "../include/delay_queue.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Benchmark of a million pending timers: schedule from several producers, cancel half, then drain
+// sl::DelayQueue against a mutex protected std::priority_queue with tombstones for cancel
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t CAPACITY = size_t(1) << 20;
+static size_t TIMERS = 1000000;
+
+class HeapTimers {
+public:
+    explicit HeapTimers(size_t capacity) : cancelled_(capacity, 0) {}
+    size_t schedule_at(Clock::time_point deadline, uint64_t value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const size_t id = next_id_++;
+        heap_.push(Entry{deadline, id, value});
+        return id;
+    }
+    bool cancel(size_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !std::exchange(cancelled_[id], 1);
+    }
+    template<typename F>
+    size_t poll(F&& handler, Clock::time_point now) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t count = 0;
+        while (!heap_.empty() && heap_.top().deadline <= now) {
+            const Entry entry = heap_.top();
+            heap_.pop();
+            if (!cancelled_[entry.id]) {
+                handler(entry.value);
+                ++count;
+            }
+        }
+        return count;
+    }
+private:
+    struct Entry {
+        Clock::time_point deadline;
+        size_t id;
+        uint64_t value;
+        bool operator<(const Entry& other) const { return deadline > other.deadline; }
+    };
+    std::mutex mutex_;
+    std::priority_queue<Entry> heap_;
+    std::vector<uint8_t> cancelled_;
+    size_t next_id_ = 0;
+};
+
+static double since(Clock::time_point start, size_t operations) {
+    return double(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()) / double(operations);
+}
+
+template<typename Queue, typename Id>
+static void run(const char* name, Queue& queue, int threads, Clock::time_point origin) {
+    std::vector<std::vector<Id>> ids(threads);
+    const size_t per_thread = TIMERS / threads;
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937_64 rng(t);
+            ids[t].reserve(per_thread);
+            for (size_t i = 0; i < per_thread; ++i) {
+                // Deadlines spread over a minute, which spans three wheel levels at a 1ms tick
+                ids[t].push_back(queue.schedule_at(origin + std::chrono::milliseconds(rng() % 60000), i));
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    const double schedule_ns = since(start, per_thread * threads);
+
+    workers.clear();
+    start = Clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t i = 0; i < ids[t].size(); i += 2) queue.cancel(ids[t][i]);
+        });
+    }
+    for (auto& w : workers) w.join();
+    const double cancel_ns = since(start, per_thread * threads / 2);
+
+    // Drain by replaying the minute in 1ms steps without waiting for the wall clock
+    start = Clock::now();
+    size_t delivered = 0;
+    for (int ms = 0; ms <= 60000; ++ms) {
+        delivered += queue.poll([](uint64_t) {}, SIZE_MAX, origin + std::chrono::milliseconds(ms));
+    }
+    const double pop_ns = since(start, delivered);
+    std::cout << name << " " << threads << "P: schedule " << schedule_ns << "ns, cancel " << cancel_ns
+              << "ns, pop " << pop_ns << "ns, delivered " << delivered << std::endl;
+}
+
+// Adapts HeapTimers to the DelayQueue poll signature
+struct HeapAdapter {
+    HeapTimers timers{CAPACITY};
+    size_t schedule_at(Clock::time_point deadline, uint64_t value) { return timers.schedule_at(deadline, value); }
+    bool cancel(size_t id) { return timers.cancel(id); }
+    template<typename F>
+    size_t poll(F&& handler, size_t, Clock::time_point now) { return timers.poll(handler, now); }
+};
+
+// Usage: delay_queue_benchmark [timers]
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        TIMERS = std::min<size_t>(std::strtoull(argv[1], nullptr, 10), CAPACITY);
+    }
+    for (int threads : {1, 2, 4, 8}) {
+        {
+            const auto origin = Clock::now();
+            auto heap = std::make_unique<HeapAdapter>();
+            run<HeapAdapter, size_t>("priority_queue", *heap, threads, origin);
+        }
+        {
+            const auto origin = Clock::now();
+            auto queue = std::make_unique<sl::DelayQueue<uint64_t, CAPACITY>>(1ms, origin);
+            run<sl::DelayQueue<uint64_t, CAPACITY>, sl::TimerId>("DelayQueue    ", *queue, threads, origin);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "../include/message_pool.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+// Benchmark of pointer passing through MPMCQueue<T*> with three ways to allocate the payload:
+// global new/delete, a shared std::pmr::synchronized_pool_resource and sl::MessagePool
+struct Payload {
+    std::array<char, 240> bytes;
+    uint64_t id;
+};
+
+static int ITEMS_PER_PRODUCER = 1000000;
+
+template<typename Acquire, typename Release>
+static double run(const char* name, int threads, Acquire acquire, Release release) {
+    sl::MPMCQueue<Payload*, 4096> queue;
+    std::atomic<int> consumed(0);
+    const int total = threads * ITEMS_PER_PRODUCER;
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int p = 0; p < threads; ++p) {
+        workers.emplace_back([&, p] {
+            for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                Payload* object;
+                while ((object = acquire(p)) == nullptr) {
+                    sl::cpu_relax();
+                }
+                object->id = i;
+                queue.push(object);
+            }
+        });
+    }
+    for (int c = 0; c < threads; ++c) {
+        workers.emplace_back([&, c] {
+            Payload* object;
+            while (consumed.load(std::memory_order_relaxed) < total) {
+                if (queue.try_pop(object)) {
+                    release(c, object);
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    const double ns_per_message = double(elapsed.count()) / total;
+    std::cout << name << " " << threads << "P/" << threads << "C: "
+              << elapsed.count() / 1000000 << "ms, " << ns_per_message << "ns/message" << std::endl;
+    return ns_per_message;
+}
+
+// Usage: message_pool_benchmark [items_per_producer]
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        ITEMS_PER_PRODUCER = std::atoi(argv[1]);
+    }
+    for (int threads : {1, 2, 4, 8}) {
+        run("malloc     ", threads,
+            [](int) { return new Payload; },
+            [](int, Payload* p) { delete p; });
+
+        std::pmr::synchronized_pool_resource resource;
+        std::pmr::polymorphic_allocator<Payload> allocator(&resource);
+        run("std::pmr   ", threads,
+            [&](int) { return allocator.allocate(1); },
+            [&](int, Payload* p) { allocator.deallocate(p, 1); });
+
+        sl::MessagePool<Payload, 8192> pool(threads, threads);
+        std::vector<sl::MessagePool<Payload, 8192>::Producer> producers;
+        std::vector<sl::MessagePool<Payload, 8192>::Consumer> consumers;
+        for (int i = 0; i < threads; ++i) {
+            producers.push_back(pool.getProducer(i));
+            consumers.push_back(pool.getConsumer(i));
+        }
+        run("MessagePool", threads,
+            [&](int p) { return producers[p].acquire(); },
+            [&](int c, Payload* p) { consumers[c].release(p); });
+        uint64_t exhausted = 0;
+        for (const auto& stats : pool.stats()) exhausted += stats.exhausted_;
+        std::cout << "MessagePool exhausted acquires: " << exhausted << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "../include/message_queue.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <variant>
+#include <vector>
+
+// Four gateway message types of 16 to 320 bytes, mostly small ones, pushed through one queue as
+// sl::MessageQueue, MPMCQueue<std::variant<...>> (every cell sized for Snapshot) and
+// MPMCQueue<Message*> (an allocation and a virtual call per message)
+static int ITEMS_PER_PRODUCER = 1000000;
+static constexpr size_t SLOTS = 4096;
+
+struct Message{
+    virtual ~Message() = default;
+    virtual uint64_t apply() const noexcept = 0;
+};
+struct Heartbeat final : Message{
+    uint64_t session = 0;
+    explicit Heartbeat(uint64_t s = 0) : session(s) {}
+    uint64_t apply() const noexcept override { return session; }
+};
+struct Quote final : Message{
+    uint64_t id = 0;
+    int64_t bid = 0, ask = 0;
+    uint32_t bid_size = 0, ask_size = 0;
+    explicit Quote(uint64_t i = 0) : id(i), bid(int64_t(i)), ask(int64_t(i) + 1) {}
+    uint64_t apply() const noexcept override { return id + uint64_t(ask - bid); }
+};
+struct Order final : Message{
+    uint64_t id = 0;
+    int64_t price = 0;
+    char symbol[96] = {};
+    explicit Order(uint64_t i = 0) : id(i), price(int64_t(i)) {}
+    uint64_t apply() const noexcept override { return id; }
+};
+struct Snapshot final : Message{
+    uint64_t sequence = 0;
+    uint64_t levels[38] = {};
+    explicit Snapshot(uint64_t s = 0) : sequence(s) {}
+    uint64_t apply() const noexcept override { return sequence; }
+};
+
+// 8 messages out of 16 are heartbeats, 5 quotes, 2 orders and 1 snapshot
+template<typename F>
+static void produce(uint64_t i, F &&emit) {
+    switch (i & 15) {
+        case 0: emit(Snapshot(i)); break;
+        case 1: case 2: emit(Order(i)); break;
+        case 3: case 4: case 5: case 6: case 7: emit(Quote(i)); break;
+        default: emit(Heartbeat(i)); break;
+    }
+}
+
+struct Inline{
+    sl::MessageQueue<Heartbeat, Quote, Order, Snapshot> queue_{SLOTS};
+    void push(uint64_t i) { produce(i, [this](auto &&m) { queue_.push(std::move(m)); }); }
+    uint64_t pop() {
+        uint64_t result = 0;
+        queue_.pop([&](auto &m) { result = m.apply(); });
+        return result;
+    }
+};
+struct Variant{
+    using Any = std::variant<Heartbeat, Quote, Order, Snapshot>;
+    sl::MPMCQueue<Any, SLOTS> queue_;
+    void push(uint64_t i) { produce(i, [this](auto &&m) { queue_.push(Any(std::move(m))); }); }
+    uint64_t pop() {
+        Any any;
+        queue_.pop(any);
+        return std::visit([](auto &m) { return m.apply(); }, any);
+    }
+};
+struct Pointer{
+    sl::MPMCQueue<Message*, SLOTS> queue_;
+    void push(uint64_t i) {
+        produce(i, [this](auto &&m) { queue_.push(new std::remove_cvref_t<decltype(m)>(std::move(m))); });
+    }
+    uint64_t pop() {
+        Message *message = nullptr;
+        queue_.pop(message);
+        const uint64_t result = message->apply();
+        delete message;
+        return result;
+    }
+};
+
+template<typename Queue>
+static void run(const char* name, int threads) {
+    auto queue = std::make_unique<Queue>();
+    const int producers = threads > 1 ? threads / 2 : 1;
+    const int consumers = threads > 1 ? threads - producers : 0;
+    std::atomic<uint64_t> checksum{0};
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    if (consumers == 0) {
+        // One thread alternates push and pop, the uncontended cost of a round trip
+        uint64_t sum = 0;
+        for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+            queue->push(uint64_t(i));
+            sum += queue->pop();
+        }
+        checksum += sum;
+    } else {
+        const int64_t total = int64_t(producers) * ITEMS_PER_PRODUCER;
+        for (int p = 0; p < producers; ++p) {
+            workers.emplace_back([&] {
+                for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) queue->push(uint64_t(i));
+            });
+        }
+        for (int c = 0; c < consumers; ++c) {
+            const int64_t share = total / consumers + (c < total % consumers ? 1 : 0);
+            workers.emplace_back([&, share] {
+                uint64_t sum = 0;
+                for (int64_t i = 0; i < share; ++i) sum += queue->pop();
+                checksum += sum;
+            });
+        }
+        for (auto& w : workers) w.join();
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    const double ns_per_message = double(elapsed.count()) / (double(producers) * ITEMS_PER_PRODUCER);
+    std::cout << name << " " << threads << "T: " << elapsed.count() / 1000000 << "ms, "
+              << ns_per_message << "ns/message, checksum " << checksum.load() << std::endl;
+}
+
+// Usage: message_queue_benchmark [items_per_producer]
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        ITEMS_PER_PRODUCER = std::atoi(argv[1]);
+    }
+    std::cout << "ring bytes: MessageQueue " << SLOTS * (sl::cache_line + 16) << ", variant "
+              << SLOTS * sizeof(sl::Cell<Variant::Any, true>) << ", pointer "
+              << SLOTS * sizeof(sl::Cell<Message*, false>) << " plus the heap" << std::endl;
+    for (int threads : {1, 2, 4, 8, 16}) {
+        run<Inline>("MessageQueue        ", threads);
+        run<Variant>("MPMCQueue<variant>  ", threads);
+        run<Pointer>("MPMCQueue<Message*> ", threads);
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "../include/atomic_queue.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Throughput of int64_t messages through MPMCQueue and the 16 byte slot PackedMPMCQueue
+// Build with -mcx16 on x86-64, otherwise FastMPMCQueue falls back to MPMCQueue and only that one runs
+static int ITEMS_PER_PRODUCER = 1000000;
+static constexpr size_t SIZE = 4096;
+
+template<typename Queue>
+static void run(const char* name, int threads) {
+    Queue queue;
+    const int producers = threads > 1 ? threads / 2 : 1;
+    const int consumers = threads > 1 ? threads - producers : 0;
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    if (consumers == 0) {
+        // One thread alternates push and pop, the uncontended cost of a round trip
+        int64_t value;
+        for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+            queue.push(i);
+            queue.pop(value);
+        }
+    } else {
+        const int64_t total = int64_t(producers) * ITEMS_PER_PRODUCER;
+        for (int p = 0; p < producers; ++p) {
+            workers.emplace_back([&] {
+                for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) queue.push(i);
+            });
+        }
+        for (int c = 0; c < consumers; ++c) {
+            // Split the total so every consumer pops a fixed share
+            const int64_t share = total / consumers + (c < total % consumers ? 1 : 0);
+            workers.emplace_back([&, share] {
+                int64_t value;
+                for (int64_t i = 0; i < share; ++i) queue.pop(value);
+            });
+        }
+        for (auto& w : workers) w.join();
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    const double ns_per_message = double(elapsed.count()) / (double(producers) * ITEMS_PER_PRODUCER);
+    std::cout << name << " " << threads << "T: " << elapsed.count() / 1000000 << "ms, "
+              << ns_per_message << "ns/message" << std::endl;
+}
+
+// Usage: packed_queue_benchmark [items_per_producer]
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        ITEMS_PER_PRODUCER = std::atoi(argv[1]);
+    }
+    std::cout << "cmpxchg16b " << (sl::has_cas16 ? "available" : "unavailable") << std::endl;
+    for (int threads : {1, 2, 4, 8, 16}) {
+        run<sl::MPMCQueue<int64_t, SIZE>>("MPMCQueue      ", threads);
+        if constexpr (sl::has_cas16) {
+            run<sl::FastMPMCQueue<int64_t, SIZE>>("PackedMPMCQueue", threads);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include "../include/pipeline.hpp"
+#include <iostream>
+#include <string>
+
+// Example demonstrating a decode -> normalise -> publish pipeline
+int main() {
+    const int TOTAL_ITEMS = 100000;
+    std::atomic<long long> checksum(0);
+
+    auto pipeline = sl::PipelineBuilder<std::string, std::string, 4096>()
+        // Two decoder threads share the input, so the first link is SPMC
+        .stage("decode", {.parallelism_ = 2}, [](std::string raw) { return std::stoll(raw); })
+        // One normaliser reads from both decoders through an MPSC link
+        .stage("normalise", {.parallelism_ = 1, .batch_size_ = 64}, [](long long v) { return v * 10; })
+        // A single publisher, the last link is SPSC
+        .sink("publish", {.parallelism_ = 1}, [&](long long v) {
+            checksum.fetch_add(v, std::memory_order_relaxed);
+        })
+        .build();
+
+    pipeline.start();
+    for (int i = 0; i < TOTAL_ITEMS; ++i) {
+        pipeline.push(std::to_string(i));
+    }
+    // End of stream, stages drain and exit one after another
+    pipeline.close();
+    pipeline.join();
+
+    for (const auto& stage : pipeline.stats()) {
+        std::cout << stage.name_ << " [" << sl::to_string(stage.input_kind_) << " x" << stage.parallelism_ << "]"
+                  << " processed=" << stage.processed_
+                  << " mean_batch=" << stage.mean_batch()
+                  << " idle_polls=" << stage.idle_polls_ << std::endl;
+    }
+    std::cout << "Checksum: " << checksum.load() << std::endl;
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "../include/atomic_queue.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Startup and teardown cost of a 1M slot MPMCQueue with 128 byte cells, for each initialisation mode:
+// eager placement-new, zero pages faulted on first use, and zero pages prefaulted by 1 or N threads
+// A second payload with a user-provided destructor makes teardown walk the cells up to the high-water mark
+using Clock = std::chrono::steady_clock;
+using Payload = std::array<char, 48>; // not IsTrivial, so every cell is a seq line plus a data line
+struct Owning{
+    std::string text;             // empty, so destroying it only reads the cell
+    std::array<char, 16> bytes{};
+};
+static_assert(!std::is_trivially_destructible_v<Owning> && sizeof(Owning) == sizeof(Payload));
+static constexpr size_t SLOTS = size_t(1) << 20;
+
+static size_t resident_mb() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * size_t(sysconf(_SC_PAGESIZE)) / (1024 * 1024);
+}
+
+static double ms_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// laps is 0 to use only the first message, 1 to touch every cell once before teardown
+template<typename Queue, typename Element, typename Prepare>
+static void run(const char* name, Prepare prepare, size_t laps = 1) {
+    const size_t rss_before = resident_mb();
+    auto start = Clock::now();
+    auto queue = std::make_unique<Queue>();
+    prepare(*queue);
+    const double construct_ms = ms_since(start);
+    const size_t rss_built = resident_mb() - rss_before;
+
+    // First message, then one full lap so every page has been touched
+    start = Clock::now();
+    Element value{};
+    queue->push(value);
+    queue->pop(value);
+    const double first_us = ms_since(start) * 1000.0;
+    start = Clock::now();
+    for (size_t i = 0; i < SLOTS * laps; ++i) {
+        queue->push(value);
+        queue->pop(value);
+    }
+    const double lap_ms = ms_since(start);
+    const size_t rss_used = resident_mb() - rss_before;
+
+    start = Clock::now();
+    queue.reset();
+    const double destroy_ms = ms_since(start);
+    std::cout << name << ": construct " << construct_ms << "ms (RSS +" << rss_built << "MB), first message "
+              << first_us << "us, first lap " << lap_ms << "ms (RSS +" << rss_used << "MB), destroy "
+              << destroy_ms << "ms" << std::endl;
+}
+
+// Usage: queue_init_benchmark [prefault_threads]
+int main(int argc, char** argv) {
+    const size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    using Eager = sl::MPMCQueue<Payload, SLOTS>;
+    using ZeroPage = sl::MPMCQueue<Payload, SLOTS, true, sl::EnablePowerOfTwo, sl::UseZeroPageBuffer>;
+    using EagerOwning = sl::MPMCQueue<Owning, SLOTS>;
+    using ZeroPageOwning = sl::MPMCQueue<Owning, SLOTS, true, sl::EnablePowerOfTwo, sl::UseZeroPageBuffer>;
+    std::cout << "cell " << sizeof(sl::Cell<Payload, true>) << " bytes, " << SLOTS << " slots" << std::endl;
+    run<Eager, Payload>("eager          ", [](Eager&) {});
+    run<ZeroPage, Payload>("zero page      ", [](ZeroPage&) {});
+    run<ZeroPage, Payload>("prefault 1     ", [](ZeroPage& q) { q.prefault(1); });
+    run<ZeroPage, Payload>("prefault N     ", [threads](ZeroPage& q) { q.prefault(threads); });
+    // Non-trivial destructor: teardown walks cells up to the high-water mark, the whole ring after a lap
+    run<EagerOwning, Owning>("eager dtor lap ", [](EagerOwning&) {});
+    run<EagerOwning, Owning>("eager dtor 1   ", [](EagerOwning&) {}, 0);
+    run<ZeroPageOwning, Owning>("zero dtor lap  ", [](ZeroPageOwning&) {});
+    run<ZeroPageOwning, Owning>("zero dtor 1    ", [](ZeroPageOwning&) {}, 0);
+    return 0;
+}
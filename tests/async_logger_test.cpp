@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include "../include/async_logger.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Fixture that hands each test a fresh temporary log file
+class AsyncLoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char name[] = "/tmp/async_logger_test_XXXXXX";
+        fd = mkstemp(name);
+        ASSERT_GE(fd, 0);
+        path = name;
+    }
+    void TearDown() override {
+        ::close(fd);
+        std::remove(path.c_str());
+    }
+    std::vector<std::string> lines() const {
+        std::ifstream file(path);
+        std::vector<std::string> result;
+        std::string line;
+        while (std::getline(file, line)) result.push_back(line);
+        return result;
+    }
+    int fd = -1;
+    std::string path;
+};
+
+// Strip the "seconds.nanoseconds LEVEL " prefix
+static std::string body(const std::string& line) {
+    const size_t first = line.find(' ');
+    const size_t second = line.find_first_not_of(' ', line.find(' ', first + 1));
+    return line.substr(second);
+}
+
+// Test argument encoding, including strings that die right after the call
+TEST_F(AsyncLoggerTest, FormatsArguments) {
+    {
+        sl::AsyncLogger<> logger(fd);
+        ASSERT_TRUE(logger.good());
+        {
+            std::string temporary = "temporary";
+            EXPECT_TRUE(logger.info("int=%d long=%lld double=%.2f str=%s", 42, -7ll, 3.14159, temporary));
+        }
+        std::string_view view = std::string_view("view-and-more").substr(0, 4);
+        EXPECT_TRUE(logger.warn("view=%s literal=%s char=%c", view, "lit", 'x'));
+        const char* null_text = nullptr;
+        EXPECT_TRUE(logger.error("null=%s no args", null_text));
+        logger.flush();
+        const auto written = lines();
+        ASSERT_EQ(written.size(), 3u);
+        EXPECT_EQ(body(written[0]), "int=42 long=-7 double=3.14 str=temporary");
+        EXPECT_NE(written[0].find(" INFO "), std::string::npos);
+        EXPECT_EQ(body(written[1]), "view=view literal=lit char=x");
+        EXPECT_NE(written[1].find(" WARN "), std::string::npos);
+        EXPECT_EQ(body(written[2]), "null=(null) no args");
+        EXPECT_GT(logger.written_bytes(), 0u);
+    }
+}
+
+// Test that messages below the level are filtered on the hot path
+TEST_F(AsyncLoggerTest, LevelFilter) {
+    sl::AsyncLogger<> logger(fd);
+    logger.set_level(sl::LogLevel::Warn);
+    EXPECT_TRUE(logger.debug("hidden %d", 1));
+    EXPECT_TRUE(logger.info("hidden %d", 2));
+    EXPECT_TRUE(logger.error("shown %d", 3));
+    logger.flush();
+    const auto written = lines();
+    ASSERT_EQ(written.size(), 1u);
+    EXPECT_EQ(body(written[0]), "shown 3");
+}
+
+// Test that the destructor drains everything still in the rings
+TEST_F(AsyncLoggerTest, DestructorDrains) {
+    {
+        sl::AsyncLogger<sl::BlockWhenFull, 4096> logger(path.c_str());
+        for (int i = 0; i < 1000; ++i) {
+            logger.info("line %d", i);
+        }
+    }
+    const auto written = lines();
+    ASSERT_EQ(written.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(body(written[i]), "line " + std::to_string(i));
+    }
+}
+
+// Test that rings of exited threads are reused, far more threads than ring slots log in turn
+TEST_F(AsyncLoggerTest, ThreadChurn) {
+    constexpr int THREADS = 4 * sl::max_log_threads;
+    {
+        sl::AsyncLogger<sl::BlockWhenFull, 4096> logger(fd);
+        for (int t = 0; t < THREADS; ++t) {
+            std::thread([&, t] { EXPECT_TRUE(logger.info("thread %d", t)); }).join();
+        }
+    }
+    const auto written = lines();
+    ASSERT_EQ(written.size(), size_t(THREADS));
+    for (int t = 0; t < THREADS; ++t) {
+        EXPECT_EQ(body(written[t]), "thread " + std::to_string(t));
+    }
+}
+
+// Test per-thread ordering and completeness with a small ring that wraps often
+TEST_F(AsyncLoggerTest, MultipleThreadsBlocking) {
+    constexpr int THREADS = 8;
+    constexpr int ITEMS = 5000;
+    {
+        sl::AsyncLogger<sl::BlockWhenFull, 4096> logger(fd);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < ITEMS; ++i) {
+                    // Vary the record size so wraps land at different offsets
+                    EXPECT_TRUE(logger.info("%d %d %s", t, i, std::string(size_t(i % 37), 'p')));
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        logger.flush();
+        EXPECT_EQ(logger.dropped(), 0u);
+        // Blocking cannot help a record larger than half the ring, it is dropped and counted
+        EXPECT_FALSE(logger.info("%s", std::string(4096, 'x')));
+        EXPECT_EQ(logger.dropped(), 1u);
+    }
+    std::vector<int> next(THREADS, 0);
+    for (const auto& line : lines()) {
+        std::istringstream fields(body(line));
+        int t, i;
+        std::string padding;
+        fields >> t >> i >> padding;
+        ASSERT_GE(t, 0);
+        ASSERT_LT(t, THREADS);
+        EXPECT_EQ(i, next[t]);
+        EXPECT_EQ(padding.size(), size_t(i % 37));
+        next[t] = i + 1;
+    }
+    for (int t = 0; t < THREADS; ++t) {
+        EXPECT_EQ(next[t], ITEMS);
+    }
+}
+
+// Test that every message is either written or counted, and drops are reported in the log
+TEST_F(AsyncLoggerTest, CountWhenFull) {
+    constexpr int ITEMS = 20000;
+    uint64_t dropped = 0;
+    int accepted = 0;
+    {
+        sl::AsyncLogger<sl::CountWhenFull, 4096> logger(fd);
+        for (int i = 0; i < ITEMS; ++i) {
+            accepted += logger.info("item %d %s", i, "padding-to-fill-the-ring-quickly");
+        }
+        // Larger than half the ring, always rejected
+        EXPECT_FALSE(logger.info("%s", std::string(4096, 'x')));
+        logger.flush();
+        dropped = logger.dropped();
+    }
+    int items = 0;
+    uint64_t reported = 0;
+    for (const auto& line : lines()) {
+        const std::string text = body(line);
+        if (text.rfind("item ", 0) == 0) {
+            ++items;
+        } else {
+            unsigned long long n = 0;
+            ASSERT_EQ(std::sscanf(text.c_str(), "logger: dropped %llu", &n), 1) << text;
+            reported += n;
+        }
+    }
+    EXPECT_EQ(items, accepted);
+    EXPECT_EQ(uint64_t(ITEMS - accepted) + 1, dropped);
+    EXPECT_EQ(reported, dropped);
+}
+
+// Test that DropWhenFull never blocks and never writes a report, but still counts what it discards
+TEST_F(AsyncLoggerTest, DropWhenFull) {
+    constexpr int ITEMS = 20000;
+    int accepted = 0;
+    {
+        sl::AsyncLogger<sl::DropWhenFull, 4096> logger(fd);
+        for (int i = 0; i < ITEMS; ++i) {
+            accepted += logger.info("item %d %s", i, "padding-to-fill-the-ring-quickly");
+        }
+        EXPECT_LT(accepted, ITEMS);
+        EXPECT_FALSE(logger.info("%s", std::string(4096, 'x')));
+        logger.flush();
+        EXPECT_EQ(logger.dropped(), uint64_t(ITEMS - accepted) + 1);
+    }
+    const auto written = lines();
+    EXPECT_EQ(written.size(), size_t(accepted));
+    for (const auto& line : written) {
+        EXPECT_EQ(body(line).rfind("item ", 0), 0u);
+    }
+}
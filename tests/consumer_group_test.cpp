@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "../include/atomic_queue.hpp"
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Test that a fresh reader sees nothing before the first push
+TEST(ConsumerGroupTest, ReaderStartsEmpty) {
+    sl::SPMCQueue<int, 8> queue;
+    auto reader = queue.getReader();
+    EXPECT_EQ(reader.read(), nullptr);
+    queue.push(7);
+    int *value = reader.read();
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(*value, 7);
+    EXPECT_EQ(reader.read(), nullptr);
+}
+
+// Test group lookup by name and member registration
+TEST(ConsumerGroupTest, Registration) {
+    sl::SPMCQueue<int, 8> queue;
+    auto risk = queue.getGroup("risk");
+    ASSERT_TRUE(risk);
+    EXPECT_EQ(risk.name(), "risk");
+    EXPECT_TRUE(risk.lossless());
+    auto again = queue.getGroup("risk", false);
+    EXPECT_EQ(again.group_, risk.group_);
+    for (size_t i = 0; i < sl::max_group_members; ++i) {
+        EXPECT_TRUE(risk.join());
+    }
+    EXPECT_FALSE(risk.join());
+}
+
+// Test that lossy groups are refused for types a torn copy would break
+TEST(ConsumerGroupTest, LossyNeedsTriviallyCopyable) {
+    sl::SPMCQueue<std::string, 8> queue;
+    EXPECT_FALSE(queue.getGroup("dashboard", false));
+    auto recorder = queue.getGroup("recorder");
+    ASSERT_TRUE(recorder);
+    queue.push(std::string(64, 'x'));
+    auto member = recorder.join();
+    std::string value;
+    EXPECT_TRUE(member.try_read(value));
+    EXPECT_EQ(value, std::string(64, 'x'));
+}
+
+// Test that the slowest lossless group holds the producer back
+TEST(ConsumerGroupTest, LosslessGating) {
+    sl::SPMCQueue<int, 4> queue;
+    auto group = queue.getGroup("recorder");
+    auto member = group.join();
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    EXPECT_FALSE(queue.try_push(4));
+    int value;
+    EXPECT_TRUE(member.try_read(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(queue.try_push(4));
+    for (int i = 1; i <= 4; ++i) {
+        EXPECT_TRUE(member.try_read(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(member.try_read(value));
+}
+
+// Test that a lossy group skips what the producer overwrote
+TEST(ConsumerGroupTest, LossyGroupMisses) {
+    sl::SPMCQueue<int, 4> queue;
+    auto group = queue.getGroup("dashboard", false);
+    auto member = group.join();
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    std::vector<int> seen;
+    int value;
+    while (member.try_read(value)) {
+        seen.push_back(value);
+    }
+    EXPECT_EQ(group.missed(), 6u);
+    EXPECT_EQ(seen, (std::vector<int>{6, 7, 8, 9}));
+}
+
+// Test that a lossy member racing the producer never sees a torn payload or an out of order message
+TEST(ConsumerGroupTest, LossyIntegrity) {
+    struct Big {
+        uint64_t words[64];
+    };
+    const uint64_t ITEMS = 2000000;
+    sl::SPMCQueue<Big, 4> queue;
+    auto group = queue.getGroup("dashboard", false);
+    auto member = group.join();
+    std::atomic<bool> done{false};
+    uint64_t delivered = 0;
+    std::thread consumer([&] {
+        Big value;
+        uint64_t last = 0;
+        while (true) {
+            const bool finished = done.load(std::memory_order_acquire);
+            if (!member.try_read(value)) {
+                if (finished) break;
+                continue;
+            }
+            for (uint64_t word : value.words) {
+                ASSERT_EQ(word, value.words[0]) << "torn payload";
+            }
+            ASSERT_GT(value.words[0], last) << "out of order";
+            last = value.words[0];
+            ++delivered;
+        }
+    });
+    Big big;
+    for (uint64_t i = 1; i <= ITEMS; ++i) {
+        std::fill(std::begin(big.words), std::end(big.words), i);
+        queue.push(big);
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+    EXPECT_GT(delivered, 0u);
+    EXPECT_EQ(delivered + group.missed(), ITEMS);
+}
+
+// Test broadcast across groups and load balancing within each group
+TEST(ConsumerGroupTest, BroadcastAndBalance) {
+    const int ITEMS = 5000;
+    const std::vector<std::pair<const char*, int>> layout = {{"risk", 2}, {"strategy", 3}, {"recorder", 1}};
+    sl::SPMCQueue<int, 64> queue;
+    std::vector<std::vector<std::atomic<int>>> received;
+    std::vector<std::thread> threads;
+    received.reserve(layout.size());
+    for (size_t g = 0; g < layout.size(); ++g) {
+        received.emplace_back(ITEMS);
+    }
+    for (size_t g = 0; g < layout.size(); ++g) {
+        auto group = queue.getGroup(layout[g].first);
+        for (int m = 0; m < layout[g].second; ++m) {
+            auto member = group.join();
+            // Half of the members block on read, the others poll with try_read
+            threads.emplace_back([&received, member, g, m, ITEMS, members = layout[g].second]() mutable {
+                int value;
+                const int share = ITEMS / members + (m < ITEMS % members ? 1 : 0);
+                for (int i = 0; i < share; ++i) {
+                    if (m % 2 == 0) {
+                        member.read(value);
+                    } else {
+                        while (!member.try_read(value)) std::this_thread::yield();
+                    }
+                    received[g][value].fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+    threads.emplace_back([&] {
+        for (int i = 0; i < ITEMS; ++i) queue.push(i);
+    });
+    // Members block on read for their share, so shares only add up if every message was claimed exactly once
+    for (auto &t : threads) t.join();
+    for (size_t g = 0; g < layout.size(); ++g) {
+        for (int i = 0; i < ITEMS; ++i) {
+            ASSERT_EQ(received[g][i].load(), 1) << layout[g].first << " message " << i;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "../include/delay_queue.hpp"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using Queue = sl::DelayQueue<int, 1024>;
+
+// Test that nothing is delivered before its deadline and everything is delivered after it
+TEST(DelayQueueTest, DeliversAtDeadline) {
+    const auto origin = Queue::clock::now();
+    Queue queue(1ms, origin);
+    ASSERT_TRUE(queue.schedule_at(origin + 5ms, 5));
+    ASSERT_TRUE(queue.schedule_at(origin + 2ms, 2));
+    ASSERT_TRUE(queue.schedule_at(origin + 9ms, 9));
+    int value;
+    EXPECT_FALSE(queue.try_pop(value, origin + 1ms));
+    EXPECT_TRUE(queue.try_pop(value, origin + 2ms));
+    EXPECT_EQ(value, 2);
+    EXPECT_FALSE(queue.try_pop(value, origin + 4ms));
+    std::vector<int> popped;
+    EXPECT_EQ(queue.poll([&](int v) { popped.push_back(v); }, 10, origin + 20ms), 2u);
+    EXPECT_EQ(popped, (std::vector<int>{5, 9}));
+    EXPECT_FALSE(queue.try_pop(value, origin + 1s));
+}
+
+// Test that deadlines inside a tick round up instead of firing early
+TEST(DelayQueueTest, RoundsUpToTick) {
+    const auto origin = Queue::clock::now();
+    Queue queue(10ms, origin);
+    ASSERT_TRUE(queue.schedule_at(origin + 11ms, 1));
+    int value;
+    EXPECT_FALSE(queue.try_pop(value, origin + 19ms));
+    EXPECT_TRUE(queue.try_pop(value, origin + 20ms));
+}
+
+// Test deadlines on every wheel level, past the horizon and in the past, popped in deadline order one tick at a time
+TEST(DelayQueueTest, CascadesAcrossLevels) {
+    const auto origin = Queue::clock::now();
+    sl::DelayQueue<uint64_t, 1024> queue(1ns, origin);
+    std::vector<uint64_t> ticks = {0, 1, 255, 256, 257, 65535, 65536, 70000, 16777215, 16777216, 20000000,
+                                   uint64_t(1) << 32, (uint64_t(1) << 32) + 300, uint64_t(1) << 34};
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 200; ++i) ticks.push_back(rng() % (uint64_t(1) << 33));
+    for (uint64_t t : ticks) {
+        ASSERT_TRUE(queue.schedule_at(origin + std::chrono::nanoseconds(t), t));
+    }
+    std::sort(ticks.begin(), ticks.end());
+    size_t delivered = 0;
+    uint64_t value;
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        // Just before the deadline nothing new may appear
+        if (ticks[i] > 0 && (i == 0 || ticks[i - 1] != ticks[i])) {
+            EXPECT_FALSE(queue.try_pop(value, origin + std::chrono::nanoseconds(ticks[i] - 1))) << ticks[i];
+        }
+        ASSERT_TRUE(queue.try_pop(value, origin + std::chrono::nanoseconds(ticks[i]))) << ticks[i];
+        EXPECT_EQ(value, ticks[i]);
+        ++delivered;
+    }
+    EXPECT_EQ(delivered, ticks.size());
+}
+
+// Test random schedules interleaved with random clock jumps against a sorted reference
+TEST(DelayQueueTest, MatchesReference) {
+    const auto origin = Queue::clock::now();
+    sl::DelayQueue<uint64_t, 4096> queue(1ns, origin);
+    std::multiset<uint64_t> reference;
+    std::mt19937_64 rng(11);
+    uint64_t now = 0;
+    for (int round = 0; round < 2000; ++round) {
+        for (int i = rng() % 4; i > 0; --i) {
+            // Mix near and far deadlines so every level sees traffic
+            const int shift = int(rng() % 28);
+            const uint64_t deadline = now + rng() % (uint64_t(1) << shift);
+            ASSERT_TRUE(queue.schedule_at(origin + std::chrono::nanoseconds(deadline), deadline));
+            reference.insert(deadline);
+        }
+        now += rng() % (uint64_t(1) << (rng() % 20));
+        std::vector<uint64_t> popped;
+        queue.poll([&](uint64_t v) { popped.push_back(v); }, SIZE_MAX, origin + std::chrono::nanoseconds(now));
+        std::sort(popped.begin(), popped.end());
+        std::vector<uint64_t> expected(reference.begin(), reference.upper_bound(now));
+        reference.erase(reference.begin(), reference.upper_bound(now));
+        ASSERT_EQ(popped, expected) << "round " << round;
+    }
+}
+
+// Test cancel before and after firing, and stale ids after node reuse
+TEST(DelayQueueTest, Cancel) {
+    const auto origin = Queue::clock::now();
+    sl::DelayQueue<int, 2> queue(1ms, origin);
+    auto a = queue.schedule_at(origin + 1ms, 1);
+    auto b = queue.schedule_at(origin + 2ms, 2);
+    ASSERT_TRUE(a);
+    ASSERT_TRUE(b);
+    EXPECT_FALSE(queue.schedule_at(origin + 3ms, 3));
+    EXPECT_TRUE(queue.cancel(a));
+    EXPECT_FALSE(queue.cancel(a));
+    int value;
+    EXPECT_TRUE(queue.try_pop(value, origin + 5ms));
+    EXPECT_EQ(value, 2);
+    EXPECT_FALSE(queue.cancel(b));
+    EXPECT_FALSE(queue.try_pop(value, origin + 5ms));
+    // Both nodes are free again, the old ids must not cancel the new timers
+    auto c = queue.schedule_at(origin + 6ms, 6);
+    auto d = queue.schedule_at(origin + 7ms, 7);
+    ASSERT_TRUE(c);
+    ASSERT_TRUE(d);
+    EXPECT_FALSE(queue.cancel(a));
+    EXPECT_FALSE(queue.cancel(b));
+    EXPECT_EQ(queue.poll([](int) {}, 10, origin + 10ms), 2u);
+}
+
+// Test that values are destroyed exactly once on delivery, cancel and queue destruction
+TEST(DelayQueueTest, NonTrivialValues) {
+    auto token = std::make_shared<int>(0);
+    {
+        const auto origin = Queue::clock::now();
+        sl::DelayQueue<std::shared_ptr<int>, 16> queue(1ms, origin);
+        ASSERT_TRUE(queue.schedule_at(origin + 1ms, token));
+        auto cancelled = queue.schedule_at(origin + 1ms, token);
+        ASSERT_TRUE(queue.schedule_at(origin + 1h, token));
+        EXPECT_EQ(token.use_count(), 4);
+        EXPECT_TRUE(queue.cancel(cancelled));
+        std::shared_ptr<int> value;
+        EXPECT_TRUE(queue.try_pop(value, origin + 2ms));
+        value.reset();
+        EXPECT_FALSE(queue.try_pop(value, origin + 2ms));
+        EXPECT_EQ(token.use_count(), 2);
+    }
+    EXPECT_EQ(token.use_count(), 1);
+}
+
+// Test concurrent producers scheduling and cancelling while the consumer polls in real time
+TEST(DelayQueueTest, ConcurrentProducers) {
+    constexpr int PRODUCERS = 4;
+    constexpr int ITEMS = 5000;
+    sl::DelayQueue<int, 65536> queue(100us);
+    std::atomic<int> cancelled(0);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < ITEMS; ++i) {
+                auto id = queue.schedule_after(std::chrono::microseconds(i % 2000), p * ITEMS + i);
+                ASSERT_TRUE(id);
+                if (i % 3 == 0 && queue.cancel(id)) cancelled.fetch_add(1);
+            }
+        });
+    }
+    std::vector<int> seen(PRODUCERS * ITEMS, 0);
+    size_t delivered = 0;
+    // Poll in real time while the producers are still running
+    const auto deadline = Queue::clock::now() + 10s;
+    while (delivered + size_t(cancelled.load()) < size_t(PRODUCERS * ITEMS) && Queue::clock::now() < deadline) {
+        delivered += queue.poll([&](int v) { ++seen[v]; }, 256);
+    }
+    for (auto& t : producers) t.join();
+    EXPECT_EQ(delivered + size_t(cancelled.load()), size_t(PRODUCERS * ITEMS));
+    for (int v = 0; v < PRODUCERS * ITEMS; ++v) {
+        EXPECT_LE(seen[v], 1);
+        if (v % ITEMS % 3 != 0) {
+            EXPECT_EQ(seen[v], 1) << v;
+        }
+    }
+}
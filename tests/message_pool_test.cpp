@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "../include/message_pool.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Payload {
+    int id;
+    std::string body;
+    Payload(int id_, std::string body_) : id(id_), body(std::move(body_)) {}
+};
+
+// Test acquire, release and exhaustion on a single producer
+TEST(MessagePoolTest, Exhaustion) {
+    sl::MessagePool<Payload, 4> pool(1, 1);
+    auto producer = pool.getProducer(0);
+    auto consumer = pool.getConsumer(0);
+    ASSERT_TRUE(producer);
+    ASSERT_TRUE(consumer);
+    EXPECT_FALSE(pool.getProducer(1));
+
+    std::vector<Payload*> objects;
+    for (int i = 0; i < 4; ++i) {
+        Payload *p = producer.acquire(i, "body");
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ(p->id, i);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % sl::cache_line, 0u);
+        objects.push_back(p);
+    }
+    EXPECT_EQ(producer.acquire(5, "none"), nullptr);
+
+    // Released objects come back through the return ring on the next acquire
+    consumer.release(objects[1]);
+    Payload *again = producer.acquire(6, "again");
+    EXPECT_EQ(again, objects[1]);
+    objects[1] = again;
+    for (Payload *p : objects) consumer.release(p);
+
+    auto stats = pool.stats();
+    ASSERT_EQ(stats.size(), 1u);
+    EXPECT_EQ(stats[0].capacity_, 4u);
+    EXPECT_EQ(stats[0].acquired_, 5u);
+    EXPECT_EQ(stats[0].exhausted_, 1u);
+    EXPECT_EQ(stats[0].reclaimed_, 1u);
+    EXPECT_EQ(producer.reclaim(), 4u);
+}
+
+// Test objects travelling through an MPMCQueue and returning to their owners
+TEST(MessagePoolTest, PointerPassing) {
+    const int PRODUCERS = 2;
+    const int CONSUMERS = 2;
+    const int ITEMS = 20000;
+    sl::MessagePool<Payload, 64> pool(PRODUCERS, CONSUMERS);
+    sl::MPMCQueue<Payload*, 128> queue;
+    std::atomic<int> consumed(0);
+    std::atomic<long long> sum(0);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        threads.emplace_back([&, p] {
+            auto producer = pool.getProducer(p);
+            for (int i = 0; i < ITEMS; ++i) {
+                Payload *object;
+                while ((object = producer.acquire(i, "x")) == nullptr) {
+                    std::this_thread::yield();
+                }
+                queue.push(object);
+            }
+        });
+    }
+    for (int c = 0; c < CONSUMERS; ++c) {
+        threads.emplace_back([&, c] {
+            auto consumer = pool.getConsumer(c);
+            Payload *object;
+            while (consumed.load(std::memory_order_relaxed) < PRODUCERS * ITEMS) {
+                if (queue.try_pop(object)) {
+                    sum.fetch_add(object->id, std::memory_order_relaxed);
+                    consumer.release(object);
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    EXPECT_EQ(consumed.load(), PRODUCERS * ITEMS);
+    EXPECT_EQ(sum.load(), static_cast<long long>(PRODUCERS) * ITEMS * (ITEMS - 1) / 2);
+    for (int p = 0; p < PRODUCERS; ++p) {
+        auto producer = pool.getProducer(p);
+        producer.reclaim();
+        auto stats = pool.stats()[p];
+        EXPECT_EQ(stats.acquired_, uint64_t(ITEMS));
+        EXPECT_EQ(stats.free_, 64u);
+    }
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
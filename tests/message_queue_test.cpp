@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include "../include/message_queue.hpp"
+#include <array>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Heartbeat{
+    uint32_t session;
+};
+struct Order{
+    uint64_t id;
+    int64_t price;
+    std::array<char, 100> symbol; // spans two slots
+};
+struct Snapshot{
+    uint64_t sequence;
+    std::array<uint64_t, 40> levels; // spans six slots
+};
+struct Text{
+    std::string body;
+};
+struct Owned{
+    std::unique_ptr<int> value;
+};
+
+static_assert(sl::message_slots<Heartbeat> == 1);
+static_assert(sl::message_slots<Order> == 2);
+static_assert(sl::message_slots<Snapshot> == 6);
+static_assert(sl::IsValidMessageList<Heartbeat, Order, Text>);
+static_assert(!sl::IsValidMessageList<Heartbeat, Order, Heartbeat>);
+static_assert(!sl::IsValidMessageList<>);
+
+// Counts live instances so teardown can be checked
+struct Tracked{
+    static inline int live = 0;
+    int value;
+    Tracked(int v) noexcept : value(v) { ++live; }
+    Tracked(const Tracked& other) noexcept : value(other.value) { ++live; }
+    ~Tracked() { --live; }
+};
+
+// Test that each type reaches its own handler, in FIFO order, and only takes the slots it needs
+TEST(MessageQueueTest, DispatchAndSlots) {
+    sl::MessageQueue<Heartbeat, Order, Snapshot, Text> queue(64);
+    int value = 0;
+    EXPECT_FALSE(queue.try_pop([](auto&) {}));
+    queue.push(Heartbeat{7});
+    EXPECT_EQ(queue.size(), 1u);
+    queue.push(Order{42, -5, {"ESZ6"}});
+    EXPECT_EQ(queue.size(), 3u);
+    Snapshot snapshot{9, {}};
+    snapshot.levels[39] = 123;
+    queue.push(snapshot);
+    EXPECT_EQ(queue.size(), 9u);
+    EXPECT_TRUE(queue.try_emplace<Text>(std::string(200, 'x')));
+
+    std::vector<int> order;
+    auto handler = sl::Overloaded{
+        [&](Heartbeat& h) { order.push_back(0); value += int(h.session); },
+        [&](Order& o) { order.push_back(1); EXPECT_EQ(o.id, 42u); EXPECT_EQ(o.price, -5); EXPECT_STREQ(o.symbol.data(), "ESZ6"); },
+        [&](Snapshot& s) { order.push_back(2); EXPECT_EQ(s.sequence, 9u); EXPECT_EQ(s.levels[39], 123u); },
+        [&](Text& t) { order.push_back(3); EXPECT_EQ(t.body, std::string(200, 'x')); }
+    };
+    while (queue.try_pop(handler)) {}
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(value, 7);
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+// Test full detection and messages that would straddle the end of the ring
+TEST(MessageQueueTest, FullAndWrap) {
+    sl::MessageQueue<Heartbeat, Snapshot> queue(16);
+    uint64_t expected = 0;
+    uint64_t received = 0;
+    auto handler = sl::Overloaded{
+        [&](Heartbeat& h) { EXPECT_EQ(h.session, received++); },
+        [&](Snapshot& s) { EXPECT_EQ(s.sequence, received++); EXPECT_EQ(s.levels[0], s.sequence); }
+    };
+    // 1 + 6 slots per round shifts the start of every snapshot, so some of them wrap
+    for (int round = 0; round < 50; ++round) {
+        EXPECT_TRUE(queue.try_push(Heartbeat{uint32_t(expected++)}));
+        Snapshot snapshot{expected, {}};
+        snapshot.levels[0] = expected++;
+        EXPECT_TRUE(queue.try_push(snapshot));
+        EXPECT_TRUE(queue.try_pop(handler));
+        EXPECT_TRUE(queue.try_pop(handler));
+    }
+    EXPECT_EQ(received, expected);
+
+    for (int i = 0; i < 16; ++i) {
+        EXPECT_TRUE(queue.try_push(Heartbeat{uint32_t(expected++)}));
+    }
+    EXPECT_FALSE(queue.try_push(Heartbeat{0}));
+    EXPECT_FALSE(queue.try_push(Snapshot{}));
+    while (queue.try_pop(handler)) {}
+    EXPECT_EQ(received, expected);
+}
+
+// Test that a size that is not a power of two, or too small for two of the largest message, is rounded up
+TEST(MessageQueueTest, SizeRoundsUp) {
+    EXPECT_EQ((sl::MessageQueue<Heartbeat, Snapshot>(16).capacity()), 16u);
+    EXPECT_EQ((sl::MessageQueue<Heartbeat, Snapshot>(20).capacity()), 32u);
+    EXPECT_EQ((sl::MessageQueue<Heartbeat, Snapshot>(0).capacity()), 16u);
+    sl::MessageQueue<Heartbeat, Snapshot> queue(3);
+    uint64_t received = 0;
+    auto handler = sl::Overloaded{
+        [&](Heartbeat&) { ++received; },
+        [&](Snapshot& s) { EXPECT_EQ(s.sequence, received++); }
+    };
+    // Two snapshots always fit, so neither push spins and both come back out
+    for (uint64_t i = 0; i < 100; i += 2) {
+        queue.push(Snapshot{i, {}});
+        queue.push(Snapshot{i + 1, {}});
+        queue.pop(handler);
+        queue.pop(handler);
+    }
+    EXPECT_EQ(received, 100u);
+}
+
+// Test that handlers can move out of a message and teardown destroys only what is still queued
+TEST(MessageQueueTest, Lifetimes) {
+    {
+        sl::MessageQueue<Owned, Text> queue(8);
+        queue.push(Owned{std::make_unique<int>(5)});
+        std::unique_ptr<int> taken;
+        queue.pop(sl::Overloaded{
+            [&](Owned& o) { taken = std::move(o.value); },
+            [](Text&) {}
+        });
+        ASSERT_TRUE(taken);
+        EXPECT_EQ(*taken, 5);
+    }
+    Tracked::live = 0;
+    {
+        sl::MessageQueue<Tracked, Heartbeat> queue(8);
+        for (int i = 0; i < 3; ++i) {
+            queue.emplace<Tracked>(i);
+            queue.push(Heartbeat{uint32_t(i)});
+        }
+        queue.pop([](auto&) {});
+        queue.pop([](auto&) {});
+        EXPECT_EQ(Tracked::live, 2);
+        queue.pop([](auto&) {});
+        // These wrap past the end of the ring, teardown has to follow them
+        for (int i = 0; i < 3; ++i) {
+            queue.emplace<Tracked>(10 + i);
+        }
+        EXPECT_EQ(Tracked::live, 4);
+    }
+    EXPECT_EQ(Tracked::live, 0);
+}
+
+// Test multiple producers and consumers with mixed sizes, every message arrives exactly once
+TEST(MessageQueueTest, MultiThreading) {
+    constexpr int PRODUCERS = 4;
+    constexpr int ITEMS = 5000;
+    sl::MessageQueue<Heartbeat, Order, Snapshot> queue(256);
+    std::vector<std::atomic<int>> seen(PRODUCERS * ITEMS);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < ITEMS; ++i) {
+                const uint32_t id = uint32_t(p * ITEMS + i);
+                switch (i % 3) {
+                    case 0:
+                        queue.push(Heartbeat{id});
+                        break;
+                    case 1:
+                        while (!queue.try_push(Order{id, -int64_t(id), {}})) sl::cpu_relax();
+                        break;
+                    default: {
+                        Snapshot snapshot{id, {}};
+                        snapshot.levels.fill(id);
+                        queue.push(snapshot);
+                    }
+                }
+            }
+        });
+        threads.emplace_back([&] {
+            auto handler = sl::Overloaded{
+                [&](Heartbeat& h) { seen[h.session].fetch_add(1, std::memory_order_relaxed); },
+                [&](Order& o) {
+                    EXPECT_EQ(o.price, -int64_t(o.id));
+                    seen[o.id].fetch_add(1, std::memory_order_relaxed);
+                },
+                [&](Snapshot& s) {
+                    EXPECT_EQ(s.levels[39], s.sequence);
+                    seen[s.sequence].fetch_add(1, std::memory_order_relaxed);
+                }
+            };
+            for (int i = 0; i < ITEMS; ++i) {
+                queue.pop(handler);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    for (auto& count : seen) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
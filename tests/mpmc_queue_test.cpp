@@ -2,7 +2,7 @@
 #include "../include/atomic_queue.hpp"
 #include <thread>
 #include <vector>
-#include <windows.h>
+#include "../include/topology.hpp"
 #include <string>
 #include <pthread.h>
 #include <sched.h>
@@ -47,9 +47,7 @@ TEST(MPMCQueueTest, MultiThreading) {
     // Producer thread
     auto producer = [&](int id) {
         // Set thread affinity to ensure one thread per CPU core
-        HANDLE thread = GetCurrentThread();
-        DWORD_PTR mask = 1ULL << (id % std::thread::hardware_concurrency());
-        SetThreadAffinityMask(thread, mask);
+        sl::pin_current_thread(id % std::thread::hardware_concurrency());
         
         for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
             int value = id * ITEMS_PER_PRODUCER + i;
@@ -62,9 +60,7 @@ TEST(MPMCQueueTest, MultiThreading) {
     // Consumer thread
     auto consumer = [&](int id) {
         // Set thread affinity to ensure one thread per CPU core
-        HANDLE thread = GetCurrentThread();
-        DWORD_PTR mask = 1ULL << ((NUM_PRODUCERS + id) % std::thread::hardware_concurrency());
-        SetThreadAffinityMask(thread, mask);
+        sl::pin_current_thread((NUM_PRODUCERS + id) % std::thread::hardware_concurrency());
         int value;
         while (true) {
             if (queue.try_pop(value)) {
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "../include/atomic_queue.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+// The selector only picks the packed queue for trivial 8 byte payloads on targets with cmpxchg16b
+static_assert(std::is_same_v<sl::FastMPMCQueue<std::string, 8>, sl::MPMCQueue<std::string, 8>>);
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+static_assert(std::is_same_v<sl::FastMPMCQueue<int64_t, 8>, sl::PackedMPMCQueue<int64_t, 8>>);
+static_assert(std::is_same_v<sl::FastMPMCQueue<void*, 8>, sl::PackedMPMCQueue<void*, 8>>);
+#else
+static_assert(std::is_same_v<sl::FastMPMCQueue<int64_t, 8>, sl::MPMCQueue<int64_t, 8>>);
+#endif
+
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+// Test basic push and pop, including a ring smaller than one cache line
+TEST(PackedMPMCQueueTest, BasicOperations) {
+    sl::PackedMPMCQueue<int64_t, 2> tiny;
+    int64_t value;
+    EXPECT_FALSE(tiny.try_pop(value));
+    EXPECT_TRUE(tiny.try_push(1));
+    EXPECT_TRUE(tiny.try_push(-2));
+    EXPECT_FALSE(tiny.try_push(3));
+    EXPECT_EQ(tiny.size(), 2u);
+    EXPECT_TRUE(tiny.try_pop(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(tiny.try_pop(value));
+    EXPECT_EQ(value, -2);
+    EXPECT_FALSE(tiny.try_pop(value));
+}
+
+// Test FIFO order across laps of a remapped ring, with pointer and small payloads
+TEST(PackedMPMCQueueTest, LapsAndPayloads) {
+    sl::PackedMPMCQueue<int*, 64> pointers;
+    std::vector<int> storage(64 * 3);
+    for (int lap = 0; lap < 3; ++lap) {
+        for (int i = 0; i < 64; ++i) {
+            EXPECT_TRUE(pointers.try_push(&storage[lap * 64 + i]));
+        }
+        EXPECT_FALSE(pointers.try_push(nullptr));
+        int* p;
+        for (int i = 0; i < 64; ++i) {
+            pointers.pop(p);
+            EXPECT_EQ(p, &storage[lap * 64 + i]);
+        }
+    }
+    sl::PackedMPMCQueue<uint16_t, 16> shorts;
+    for (uint16_t i = 0; i < 100; ++i) {
+        shorts.emplace(uint16_t(i * 3));
+        uint16_t v;
+        ASSERT_TRUE(shorts.try_pop(v));
+        EXPECT_EQ(v, uint16_t(i * 3));
+    }
+}
+
+// Test multiple producers and consumers, every value arrives exactly once
+TEST(PackedMPMCQueueTest, MultiThreading) {
+    constexpr int PRODUCERS = 4;
+    constexpr int ITEMS = 5000;
+    sl::PackedMPMCQueue<uint64_t, 256> queue;
+    std::vector<std::atomic<int>> seen(PRODUCERS * ITEMS);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < ITEMS; ++i) {
+                if (i % 2) {
+                    queue.push(uint64_t(p) * ITEMS + i);
+                } else {
+                    while (!queue.try_push(uint64_t(p) * ITEMS + i)) sl::cpu_relax();
+                }
+            }
+        });
+        threads.emplace_back([&, p] {
+            uint64_t value;
+            for (int i = 0; i < ITEMS; ++i) {
+                if (p % 2) {
+                    queue.pop(value);
+                } else {
+                    while (!queue.try_pop(value)) sl::cpu_relax();
+                }
+                seen[value].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    for (auto& count : seen) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+#endif
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "../include/partitioned_queue.hpp"
+#include <thread>
+#include <vector>
+
+struct Update {
+    int symbol;
+    int seq;
+};
+struct SymbolKey {
+    int operator()(const Update &u) const noexcept { return u.symbol; }
+};
+using UpdateQueue = sl::PartitionedQueue<Update, SymbolKey, 1024, 64>;
+
+// Test that a key always maps to the same lane
+TEST(PartitionedQueueTest, KeyAffinity) {
+    UpdateQueue queue(4);
+    EXPECT_EQ(queue.lanes(), 4u);
+    for (int symbol = 0; symbol < 100; ++symbol) {
+        const size_t lane = queue.lane_of(Update{symbol, 0});
+        EXPECT_LT(lane, 4u);
+        EXPECT_EQ(queue.lane_of(Update{symbol, 42}), lane);
+    }
+}
+
+// Test per-key FIFO with several producers and one consumer per lane
+TEST(PartitionedQueueTest, PerKeyOrdering) {
+    const int LANES = 3;
+    const int SYMBOLS_PER_PRODUCER = 8;
+    const int PRODUCERS = 2;
+    const int UPDATES = 2000;
+    UpdateQueue queue(LANES);
+    std::atomic<int> consumed(0);
+    std::atomic<bool> ordered(true);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        threads.emplace_back([&, p] {
+            for (int seq = 0; seq < UPDATES; ++seq) {
+                for (int s = 0; s < SYMBOLS_PER_PRODUCER; ++s) {
+                    queue.push(Update{p * SYMBOLS_PER_PRODUCER + s, seq});
+                }
+            }
+        });
+    }
+    for (int lane = 0; lane < LANES; ++lane) {
+        threads.emplace_back([&, lane] {
+            std::vector<int> last(PRODUCERS * SYMBOLS_PER_PRODUCER, -1);
+            Update update;
+            while (consumed.load(std::memory_order_relaxed) < PRODUCERS * SYMBOLS_PER_PRODUCER * UPDATES) {
+                if (queue.try_pop(lane, update)) {
+                    if (update.seq != last[update.symbol] + 1 || queue.lane_of(update) != size_t(lane)) {
+                        ordered = false;
+                    }
+                    last[update.symbol] = update.seq;
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    EXPECT_TRUE(ordered.load());
+    EXPECT_EQ(consumed.load(), PRODUCERS * SYMBOLS_PER_PRODUCER * UPDATES);
+}
+
+// Test load reporting and rebalancing away from a hot lane
+TEST(PartitionedQueueTest, Rebalance) {
+    UpdateQueue queue(2);
+    Update update;
+    // Symbols 0..15 with symbol 0 ten times hotter than the rest
+    auto feed = [&] {
+        for (int round = 0; round < 10; ++round) {
+            for (int symbol = 0; symbol < 16; ++symbol) {
+                const int repeat = symbol == 0 ? 10 : 1;
+                for (int r = 0; r < repeat; ++r) {
+                    ASSERT_TRUE(queue.try_push(Update{symbol, round}));
+                    const size_t lane = queue.lane_of(Update{symbol, round});
+                    ASSERT_TRUE(queue.try_pop(lane, update));
+                }
+            }
+        }
+    };
+    feed();
+    auto stats = queue.lane_stats();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[0].pushed_ + stats[1].pushed_, 250u);
+    EXPECT_EQ(stats[0].popped_ + stats[1].popped_, 250u);
+    EXPECT_EQ(stats[0].partitions_ + stats[1].partitions_, 64u);
+    const double before = queue.skew();
+
+    // Not quiescent while a lane holds data
+    ASSERT_TRUE(queue.try_push(Update{1, 0}));
+    EXPECT_FALSE(queue.rebalance());
+    ASSERT_TRUE(queue.try_pop(queue.lane_of(Update{1, 0}), update));
+    EXPECT_TRUE(queue.rebalance());
+
+    feed();
+    EXPECT_LE(queue.skew(), before);
+    // The hot symbol gets a lane to itself, everything else shares the other one
+    EXPECT_LT(queue.skew(), 1.1);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include "../include/pipeline.hpp"
+#include <string>
+#include <vector>
+
+// Test SPSCQueue basic behaviour used by single-threaded links
+TEST(PipelineTest, SPSCQueue) {
+    sl::SPSCQueue<std::string, 4> queue;
+    std::string value;
+    EXPECT_FALSE(queue.try_pop(value));
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.try_push(std::to_string(i)));
+    }
+    EXPECT_FALSE(queue.try_push("full"));
+    EXPECT_EQ(queue.size(), 4u);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, std::to_string(i));
+    }
+    EXPECT_FALSE(queue.try_pop(value));
+}
+
+// Test link selection from stage parallelism
+TEST(PipelineTest, LinkKinds) {
+    EXPECT_EQ((sl::PipelineLink<int, 16>(1, 1).kind()), sl::LinkKind::SPSC);
+    EXPECT_EQ((sl::PipelineLink<int, 16>(4, 1).kind()), sl::LinkKind::MPSC);
+    EXPECT_EQ((sl::PipelineLink<int, 16>(1, 4).kind()), sl::LinkKind::SPMC);
+    EXPECT_EQ((sl::PipelineLink<int, 16>(4, 4).kind()), sl::LinkKind::MPMC);
+}
+
+// Test that every element reaches the sink and end of stream shuts the stages down in order
+TEST(PipelineTest, EndOfStream) {
+    const int ITEMS = 20000;
+    std::atomic<long long> sum(0);
+    std::atomic<int> count(0);
+    auto pipeline = sl::PipelineBuilder<int, int, 256>()
+        .stage("decode", {.parallelism_ = 2}, [](int v) { return static_cast<long long>(v) * 2; })
+        .stage("normalise", {.parallelism_ = 1, .batch_size_ = 8}, [](long long v) { return v + 1; })
+        .sink("publish", {.parallelism_ = 2}, [&](long long v) {
+            sum.fetch_add(v, std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_relaxed);
+        })
+        .build();
+    pipeline.start();
+    for (int i = 0; i < ITEMS; ++i) {
+        ASSERT_TRUE(pipeline.push(i));
+    }
+    pipeline.close();
+    pipeline.join();
+    EXPECT_EQ(count.load(), ITEMS);
+    EXPECT_EQ(sum.load(), static_cast<long long>(ITEMS) * (ITEMS - 1) + ITEMS);
+
+    auto stats = pipeline.stats();
+    ASSERT_EQ(stats.size(), 3u);
+    EXPECT_EQ(stats[0].name_, "decode");
+    EXPECT_EQ(stats[0].input_kind_, sl::LinkKind::SPMC);
+    EXPECT_EQ(stats[1].input_kind_, sl::LinkKind::MPSC);
+    EXPECT_EQ(stats[2].input_kind_, sl::LinkKind::SPMC);
+    for (auto &stage : stats) {
+        EXPECT_EQ(stage.processed_, uint64_t(ITEMS));
+        EXPECT_EQ(stage.input_depth_, 0u);
+    }
+}
+
+// Test that stop() ends a pipeline whose stream is never closed
+TEST(PipelineTest, Shutdown) {
+    auto pipeline = sl::PipelineBuilder<std::string>()
+        .stage("length", {}, [](std::string s) { return s.size(); })
+        .sink("drop", {}, [](size_t) {})
+        .build();
+    pipeline.start();
+    EXPECT_TRUE(pipeline.push(std::string("abc")));
+    pipeline.stop();
+    pipeline.join();
+    auto stats = pipeline.stats();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[0].input_kind_, sl::LinkKind::SPSC);
+    EXPECT_LE(stats[1].processed_, 1u);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "../include/topology.hpp"
+#include <fstream>
+#include <set>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// Fake sysfs tree: 2 packages x 2 cores x 2 SMT threads, one L3 and one NUMA node per package
+// cpu n and n+4 are SMT siblings, as on most x86 servers
+class TopologySysfsTest : public testing::Test {
+protected:
+    fs::path root_;
+    void write(const fs::path &path, const std::string &text) {
+        fs::create_directories(path.parent_path());
+        std::ofstream(path) << text << "\n";
+    }
+    void SetUp() override {
+        root_ = fs::temp_directory_path() / ("sl_topology_" + std::to_string(::getpid()));
+        fs::remove_all(root_);
+        write(root_ / "online", "0-7");
+        for (int cpu = 0; cpu < 8; ++cpu) {
+            const int core = cpu % 4;
+            const int package = core / 2;
+            const fs::path dir = root_ / ("cpu" + std::to_string(cpu));
+            const std::string siblings = std::to_string(core) + "," + std::to_string(core + 4);
+            write(dir / "topology" / "thread_siblings_list", siblings);
+            write(dir / "topology" / "physical_package_id", std::to_string(package));
+            fs::create_directories(dir / ("node" + std::to_string(package)));
+            write(dir / "cache" / "index0" / "level", "1");
+            write(dir / "cache" / "index0" / "type", "Data");
+            write(dir / "cache" / "index0" / "shared_cpu_list", siblings);
+            write(dir / "cache" / "index1" / "level", "1");
+            write(dir / "cache" / "index1" / "type", "Instruction");
+            write(dir / "cache" / "index1" / "shared_cpu_list", siblings);
+            write(dir / "cache" / "index2" / "level", "2");
+            write(dir / "cache" / "index2" / "type", "Unified");
+            write(dir / "cache" / "index2" / "shared_cpu_list", siblings);
+            write(dir / "cache" / "index3" / "level", "3");
+            write(dir / "cache" / "index3" / "type", "Unified");
+            write(dir / "cache" / "index3" / "shared_cpu_list",
+                  package == 0 ? "0-1,4-5" : "2-3,6-7");
+        }
+    }
+    void TearDown() override { fs::remove_all(root_); }
+};
+
+// Test cpu list parsing
+TEST(TopologyTest, ParseCpuList) {
+    EXPECT_EQ(sl::parse_cpu_list("0-3,8,10-11\n"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(sl::parse_cpu_list("5"), (std::vector<int>{5}));
+    EXPECT_TRUE(sl::parse_cpu_list("").empty());
+    EXPECT_TRUE(sl::parse_cpu_list("1-x").empty());
+}
+
+// Test discovery of SMT siblings, cache domains and NUMA nodes
+TEST_F(TopologySysfsTest, Detect) {
+    auto topology = sl::CpuTopology::detect(root_);
+    ASSERT_EQ(topology.cpus().size(), 8u);
+    const sl::CpuInfo *cpu5 = topology.find(5);
+    ASSERT_NE(cpu5, nullptr);
+    EXPECT_EQ(cpu5->core_, 1);
+    EXPECT_EQ(cpu5->smt_siblings_, (std::vector<int>{1, 5}));
+    EXPECT_EQ(cpu5->l2_, 1);
+    EXPECT_EQ(cpu5->l3_, 0);
+    EXPECT_EQ(cpu5->package_, 0);
+    EXPECT_EQ(topology.node_of(6), 1);
+    EXPECT_EQ(topology.cpus_of_node(1), (std::vector<int>{2, 3, 6, 7}));
+}
+
+// Test pairing producers with consumers on a shared L3 without SMT siblings
+TEST_F(TopologySysfsTest, PlanPairs) {
+    auto topology = sl::CpuTopology::detect(root_);
+    auto pairs = topology.plan_pairs(4, sl::ShareLevel::L3, true);
+    ASSERT_EQ(pairs.size(), 2u);
+    std::set<int> used;
+    for (auto &pair : pairs) {
+        const sl::CpuInfo *producer = topology.find(pair.producer_cpu_);
+        const sl::CpuInfo *consumer = topology.find(pair.consumer_cpu_);
+        EXPECT_EQ(producer->l3_, consumer->l3_);
+        EXPECT_NE(producer->core_, consumer->core_);
+        used.insert(pair.producer_cpu_);
+        used.insert(pair.consumer_cpu_);
+    }
+    EXPECT_EQ(used.size(), 4u);
+
+    // A shared L2 on this machine means SMT siblings, so it cannot be combined with avoid_smt
+    EXPECT_TRUE(topology.plan_pairs(1, sl::ShareLevel::L2, true).empty());
+    auto l2 = topology.plan_pairs(4, sl::ShareLevel::L2, false);
+    ASSERT_EQ(l2.size(), 4u);
+    EXPECT_EQ(topology.find(l2[0].producer_cpu_)->core_, topology.find(l2[0].consumer_cpu_)->core_);
+}
+
+// Test spreading threads over physical cores
+TEST_F(TopologySysfsTest, PlanSpread) {
+    auto topology = sl::CpuTopology::detect(root_);
+    EXPECT_EQ(topology.plan_spread(8, true), (std::vector<int>{0, 2, 1, 3}));
+    EXPECT_EQ(topology.plan_spread(2, false).size(), 2u);
+}
+
+// Test detection and placement on the machine running the test
+TEST(TopologyTest, RealMachine) {
+    auto topology = sl::CpuTopology::detect();
+#if defined(__linux__)
+    ASSERT_FALSE(topology.empty());
+    const int cpu = topology.cpus().front().cpu_;
+    EXPECT_TRUE(sl::pin_current_thread(cpu));
+    auto queue = sl::make_queue_on_node<sl::MPMCQueue<int, 64>>(topology, topology.node_of(cpu));
+    ASSERT_NE(queue, nullptr);
+    EXPECT_TRUE(queue->try_push(1));
+    // Zero-page rings are prefaulted by the pinned builder instead of by the constructor
+    using ZeroPageQueue = sl::MPMCQueue<int, 1024, true, sl::EnablePowerOfTwo, sl::UseZeroPageBuffer>;
+    auto zero_page = sl::make_queue_near<ZeroPageQueue>(cpu);
+    ASSERT_NE(zero_page, nullptr);
+    EXPECT_TRUE(zero_page->try_push(2));
+    int value = 0;
+    EXPECT_TRUE(zero_page->try_pop(value));
+    EXPECT_EQ(value, 2);
+#endif
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
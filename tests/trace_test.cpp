@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "../include/atomic_queue.hpp"
+#include <new>
+#include <thread>
+#include <vector>
+
+using TracedMPMC = sl::MPMCQueue<int, 64, true, sl::EnablePowerOfTwo, sl::UseHeapBuffer, sl::EnableTracing<4>>;
+using TracedSPMC = sl::SPMCQueue<int, 64, true, sl::EnablePowerOfTwo, sl::UseHeapBuffer, sl::EnableTracing<4>>;
+
+// Test that the disabled tracer adds nothing to the queue
+TEST(TraceTest, DisabledCompilesAway) {
+    static_assert(std::is_empty_v<sl::QueueTracer<sl::DisableTracing, sl::EnablePowerOfTwo, 4>>);
+    static_assert(sl::IsValidTracePolicy<sl::EnableTracing<16>>);
+    static_assert(!sl::IsValidTracePolicy<sl::EnableTracing<0>>);
+    static_assert(!sl::IsValidTracePolicy<int>);
+}
+
+// Test histogram bucket layout
+TEST(TraceTest, HistogramBuckets) {
+    using H = sl::HistogramSnapshot;
+    for (uint64_t v = 0; v < 2 * H::sub_buckets; ++v) {
+        EXPECT_EQ(H::bucket_index(v), v);
+    }
+    for (uint64_t v : {uint64_t(33), uint64_t(100), uint64_t(4097), uint64_t(1) << 40, UINT64_MAX}) {
+        const size_t index = H::bucket_index(v);
+        ASSERT_LT(index, H::bucket_count);
+        EXPECT_LE(H::bucket_lower_bound(index), v);
+        // Relative bucket width is bounded by the sub bucket resolution
+        EXPECT_GE(H::bucket_lower_bound(index), v - v / H::sub_buckets);
+    }
+}
+
+// Test histogram percentiles and merging
+TEST(TraceTest, HistogramPercentiles) {
+    sl::LatencyHistogram histogram;
+    for (uint64_t v = 1; v <= 1000; ++v) {
+        histogram.record(v);
+    }
+    sl::HistogramSnapshot snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count(), 1000u);
+    EXPECT_EQ(snapshot.min(), 1u);
+    EXPECT_EQ(snapshot.max(), 1000u);
+    EXPECT_DOUBLE_EQ(snapshot.mean(), 500.5);
+    EXPECT_NEAR(double(snapshot.value_at_percentile(50.0)), 500.0, 500.0 / 16);
+    EXPECT_EQ(snapshot.value_at_percentile(100.0), snapshot.bucket_lower_bound(snapshot.bucket_index(1000)));
+
+    sl::HistogramSnapshot merged;
+    merged.merge(snapshot);
+    merged.merge(snapshot);
+    EXPECT_EQ(merged.count(), 2000u);
+    EXPECT_EQ(merged.min(), 1u);
+    EXPECT_EQ(merged.max(), 1000u);
+}
+
+// Test that every Nth message is traced on MPMCQueue
+TEST(TraceTest, MPMCSampling) {
+    TracedMPMC queue;
+    int value;
+    for (int i = 0; i < 32; ++i) {
+        queue.push(i);
+        queue.pop(value);
+        EXPECT_EQ(value, i);
+    }
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(queue.try_push(i));
+        EXPECT_TRUE(queue.try_pop(value));
+    }
+    auto traces = queue.export_trace();
+    ASSERT_EQ(traces.size(), 1u);
+    EXPECT_EQ(traces[0].residency_.count(), 10u);
+    // Only the blocking calls wait on seq_, once on push and once on pop
+    EXPECT_EQ(traces[0].seq_wait_.count(), 16u);
+}
+
+// Test per-thread histograms on MPMCQueue
+TEST(TraceTest, MPMCPerThread) {
+    TracedMPMC queue;
+    const int ITEMS = 4000;
+    std::thread producer([&] {
+        for (int i = 0; i < ITEMS; ++i) queue.push(i);
+    });
+    std::thread consumer([&] {
+        int value;
+        for (int i = 0; i < ITEMS; ++i) queue.pop(value);
+    });
+    producer.join();
+    consumer.join();
+    auto traces = queue.export_trace();
+    ASSERT_EQ(traces.size(), 2u);
+    uint64_t residency = 0, waits = 0;
+    for (auto &trace : traces) {
+        residency += trace.residency_.count();
+        waits += trace.seq_wait_.count();
+    }
+    EXPECT_EQ(residency, uint64_t(ITEMS / 4));
+    EXPECT_EQ(waits, uint64_t(2 * ITEMS / 4));
+}
+
+// Test residency tracing on SPMCQueue readers
+TEST(TraceTest, SPMCResidency) {
+    TracedSPMC queue;
+    auto reader = queue.getReader();
+    for (int i = 0; i < 16; ++i) {
+        queue.push(i);
+        ASSERT_NE(reader.read(), nullptr);
+    }
+    auto traces = queue.export_trace();
+    ASSERT_EQ(traces.size(), 1u);
+    EXPECT_EQ(traces[0].residency_.count(), 4u);
+    EXPECT_EQ(traces[0].seq_wait_.count(), 0u);
+}
+
+// Test that a queue rebuilt at a destroyed queue's address does not reuse its per-thread slot
+TEST(TraceTest, RebuiltInPlace) {
+    alignas(TracedMPMC) std::byte storage[sizeof(TracedMPMC)];
+    int value;
+    for (int round = 0; round < 3; ++round) {
+        auto *queue = new (storage) TracedMPMC;
+        for (int i = 0; i < 8; ++i) {
+            queue->push(i);
+            queue->pop(value);
+        }
+        auto traces = queue->export_trace();
+        ASSERT_EQ(traces.size(), 1u);
+        EXPECT_EQ(traces[0].residency_.count(), 2u);
+        EXPECT_EQ(traces[0].seq_wait_.count(), 4u);
+        queue->~TracedMPMC();
+    }
+}
+
+// Test that slots of exited threads are reused, so late threads never fall back to the overflow slot
+TEST(TraceTest, ThreadChurn) {
+    TracedMPMC queue;
+    const int THREADS = 4 * int(sl::max_trace_threads);
+    for (int t = 0; t < THREADS; ++t) {
+        std::thread([&] {
+            int value;
+            for (int i = 0; i < 4; ++i) {
+                queue.push(i);
+                queue.pop(value);
+            }
+        }).join();
+    }
+    auto traces = queue.export_trace();
+    uint64_t residency = 0;
+    for (auto &trace : traces) {
+        EXPECT_LT(trace.slot_, sl::max_trace_threads);
+        residency += trace.residency_.count();
+    }
+    EXPECT_EQ(residency, uint64_t(THREADS));
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include "../include/atomic_queue.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+// Counts live instances so teardown can be checked
+struct Tracked {
+    static inline int live = 0;
+    int value;
+    Tracked(int v = 0) : value(v) { ++live; }
+    Tracked(const Tracked& other) : value(other.value) { ++live; }
+    Tracked& operator=(const Tracked& other) { value = other.value; return *this; }
+    ~Tracked() { --live; }
+};
+
+// Test that the buffer reads as zero and maps indices like HeapBuffer
+TEST(ZeroPageBufferTest, ZeroFilled) {
+    sl::ZeroPageBuffer<uint64_t, sl::EnablePowerOfTwo, true> buffer(1024);
+    for (size_t i = 0; i < 1024; ++i) {
+        EXPECT_EQ(buffer[i], 0u);
+    }
+    EXPECT_EQ(buffer.index_of(1024 + 5), 5u);
+    EXPECT_EQ(&buffer[1024 + 5], &buffer[5]);
+    buffer.prefault(4);
+    buffer[7] = 42;
+    EXPECT_EQ(buffer[1024 + 7], 42u);
+    sl::ZeroPageBuffer<uint64_t, sl::DisablePowerOfTwo, true> odd(1000);
+    EXPECT_EQ(odd.index_of(1003), 3u);
+}
+
+// Test the relative seq encoding across several laps, including full and empty checks
+TEST(ZeroPageBufferTest, MPMCLaps) {
+    sl::MPMCQueue<int, 4, true, sl::EnablePowerOfTwo, sl::UseZeroPageBuffer> queue;
+    int value;
+    EXPECT_FALSE(queue.try_pop(value));
+    for (int lap = 0; lap < 5; ++lap) {
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_TRUE(queue.try_push(lap * 4 + i));
+        }
+        EXPECT_FALSE(queue.try_push(-1));
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(queue.try_pop(value));
+            EXPECT_EQ(value, lap * 4 + i);
+        }
+        EXPECT_FALSE(queue.try_pop(value));
+    }
+}
+
+// Test a non power of two ring, where slots come from a modulo
+TEST(ZeroPageBufferTest, MPMCNonPowerOfTwo) {
+    sl::MPMCQueue<int, 5, true, sl::DisablePowerOfTwo, sl::UseZeroPageBuffer> queue;
+    int value;
+    for (int i = 0; i < 23; ++i) {
+        queue.push(i);
+        queue.pop(value);
+        EXPECT_EQ(value, i);
+    }
+}
+
+// Test concurrent producers and consumers on a prefaulted zero-page ring
+TEST(ZeroPageBufferTest, MPMCMultiThreading) {
+    constexpr int PRODUCERS = 4;
+    constexpr int ITEMS = 20000;
+    sl::MPMCQueue<int, 1024, true, sl::EnablePowerOfTwo, sl::UseZeroPageBuffer> queue;
+    queue.prefault(2);
+    std::atomic<long long> sum(0);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        threads.emplace_back([&] {
+            for (int i = 1; i <= ITEMS; ++i) queue.push(i);
+        });
+        threads.emplace_back([&] {
+            int value;
+            long long local = 0;
+            for (int i = 0; i < ITEMS; ++i) {
+                queue.pop(value);
+                local += value;
+            }
+            sum += local;
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(sum.load(), PRODUCERS * (long long)ITEMS * (ITEMS + 1) / 2);
+}
+
+// Test that a reader on a fresh zero-page SPMC ring sees nothing, then every message
+TEST(ZeroPageBufferTest, SPMCAndSPSC) {
+    sl::SPMCQueue<int, 8, true, sl::EnablePowerOfTwo, sl::UseZeroPageBuffer> spmc;
+    auto reader = spmc.getReader();
+    EXPECT_EQ(reader.read(), nullptr);
+    for (int i = 0; i < 20; ++i) {
+        spmc.push(i);
+        int* value = reader.read();
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(*value, i);
+    }
+    sl::SPSCQueue<std::string, 4, true, sl::EnablePowerOfTwo, sl::UseZeroPageBuffer> spsc;
+    std::string text;
+    EXPECT_FALSE(spsc.try_pop(text));
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(spsc.try_push(std::string(100, char('a' + i))));
+        ASSERT_TRUE(spsc.try_pop(text));
+        EXPECT_EQ(text, std::string(100, char('a' + i)));
+    }
+}
+
+// Test that teardown destroys exactly the elements still queued, for every buffer type
+TEST(ZeroPageBufferTest, TeardownDestroysRemaining) {
+    Tracked::live = 0;
+    {
+        sl::MPMCQueue<Tracked, 8, true, sl::EnablePowerOfTwo, sl::UseZeroPageBuffer> queue;
+        Tracked value;
+        for (int i = 0; i < 3; ++i) queue.push(Tracked(i));
+        queue.pop(value);
+        EXPECT_EQ(Tracked::live, 3);
+    }
+    EXPECT_EQ(Tracked::live, 0);
+    {
+        sl::MPMCQueue<Tracked, 8> queue;
+        for (int i = 0; i < 2; ++i) queue.push(Tracked(i));
+        EXPECT_EQ(Tracked::live, 2);
+    }
+    EXPECT_EQ(Tracked::live, 0);
+    {
+        sl::SPSCQueue<Tracked, 4, true, sl::EnablePowerOfTwo, sl::UseZeroPageBuffer> queue;
+        Tracked value;
+        for (int i = 0; i < 6; ++i) {
+            EXPECT_TRUE(queue.try_push(Tracked(i)));
+            if (i % 2) {
+                EXPECT_TRUE(queue.try_pop(value));
+            }
+        }
+        EXPECT_EQ(Tracked::live, 4);
+    }
+    EXPECT_EQ(Tracked::live, 0);
+}